@@ -1807,14 +1807,18 @@ class Board {
    private:
     struct State {
         U64 hash;
+        U64 pawn_hash;
+        U64 material_hash;
         CastlingRights castling;
         Square enpassant;
         uint8_t half_moves;
         Piece captured_piece;
 
-        State(const U64 &hash, const CastlingRights &castling, const Square &enpassant, const uint8_t &half_moves,
-              const Piece &captured_piece)
+        State(const U64 &hash, const U64 &pawn_hash, const U64 &material_hash, const CastlingRights &castling,
+              const Square &enpassant, const uint8_t &half_moves, const Piece &captured_piece)
             : hash(hash),
+              pawn_hash(pawn_hash),
+              material_hash(material_hash),
               castling(castling),
               enpassant(enpassant),
               half_moves(half_moves),
@@ -1998,7 +2002,7 @@ class Board {
         // Validate side to move
         assert((at(move.from()) < Piece::BLACKPAWN) == (stm_ == Color::WHITE));
 
-        prev_states_.emplace_back(key_, cr_, ep_sq_, hfm_, captured);
+        prev_states_.emplace_back(key_, pawn_key_, material_key_, cr_, ep_sq_, hfm_, captured);
 
         hfm_++;
         plies_++;
@@ -2011,6 +2015,8 @@ class Board {
 
             hfm_ = 0;
             key_ ^= Zobrist::piece(captured, move.to());
+            if (captured.type() == PieceType::PAWN) pawn_key_ ^= Zobrist::piece(captured, move.to());
+            material_key_ ^= materialKey(captured);
 
             // remove castling rights if rook is captured
             if (captured.type() == PieceType::ROOK && Rank::back_rank(move.to().rank(), ~stm_)) {
@@ -2115,6 +2121,8 @@ class Board {
             placePiece(piece_prom, move.to());
 
             key_ ^= Zobrist::piece(piece_pawn, move.from()) ^ Zobrist::piece(piece_prom, move.to());
+            pawn_key_ ^= Zobrist::piece(piece_pawn, move.from());
+            material_key_ ^= materialKey(piece_pawn) ^ materialKey(piece_prom, -1);
         } else {
             assert(at(move.from()) != Piece::NONE);
             assert(at(move.to()) == Piece::NONE);
@@ -2125,6 +2133,7 @@ class Board {
             placePiece(piece, move.to());
 
             key_ ^= Zobrist::piece(piece, move.from()) ^ Zobrist::piece(piece, move.to());
+            if (pt == PieceType::PAWN) pawn_key_ ^= Zobrist::piece(piece, move.from()) ^ Zobrist::piece(piece, move.to());
         }
 
         if (move.typeOf() == Move::ENPASSANT) {
@@ -2135,6 +2144,8 @@ class Board {
             removePiece(piece, move.to().ep_square());
 
             key_ ^= Zobrist::piece(piece, move.to().ep_square());
+            pawn_key_ ^= Zobrist::piece(piece, move.to().ep_square());
+            material_key_ ^= materialKey(piece);
         }
 
         key_ ^= Zobrist::sideToMove();
@@ -2171,7 +2182,10 @@ class Board {
             placePiece(king, move.from());
             placePiece(rook, move.to());
 
-            key_ = prev.hash;
+            key_      = prev.hash;
+            pawn_key_ = prev.pawn_hash;
+
+            material_key_ = prev.material_hash;
 
             return;
         } else if (move.typeOf() == Move::PROMOTION) {
@@ -2191,7 +2205,10 @@ class Board {
                 placePiece(prev.captured_piece, move.to());
             }
 
-            key_ = prev.hash;
+            key_      = prev.hash;
+            pawn_key_ = prev.pawn_hash;
+
+            material_key_ = prev.material_hash;
             return;
         } else {
             assert(at(move.to()) != Piece::NONE);
@@ -2216,14 +2233,17 @@ class Board {
             placePiece(prev.captured_piece, move.to());
         }
 
-        key_ = prev.hash;
+        key_      = prev.hash;
+        pawn_key_ = prev.pawn_hash;
+
+        material_key_ = prev.material_hash;
     }
 
     /**
      * @brief Make a null move. (Switches the side to move)
      */
     void makeNullMove() {
-        prev_states_.emplace_back(key_, cr_, ep_sq_, hfm_, Piece::NONE);
+        prev_states_.emplace_back(key_, pawn_key_, material_key_, cr_, ep_sq_, hfm_, Piece::NONE);
 
         key_ ^= Zobrist::sideToMove();
         if (ep_sq_ != Square::underlying::NO_SQ) key_ ^= Zobrist::enpassant(ep_sq_.file());
@@ -2245,6 +2265,9 @@ class Board {
         hfm_   = prev.half_moves;
         key_   = prev.hash;
 
+        pawn_key_     = prev.pawn_hash;
+        material_key_ = prev.material_hash;
+
         plies_--;
 
         stm_ = ~stm_;
@@ -2337,6 +2360,19 @@ class Board {
      * @return
      */
     [[nodiscard]] U64 hash() const { return key_; }
+
+    /**
+     * @brief Get the zobrist hash key of the pawns only, updated incrementally like hash()
+     * @return
+     */
+    [[nodiscard]] U64 pawnHash() const { return pawn_key_; }
+
+    /**
+     * @brief Get the zobrist hash key of the material configuration, i.e. the number of pieces
+     * of each type and color without kings. Updated incrementally like hash()
+     * @return
+     */
+    [[nodiscard]] U64 materialHash() const { return material_key_; }
     [[nodiscard]] Color sideToMove() const { return stm_; }
     [[nodiscard]] Square enpassantSq() const { return ep_sq_; }
     [[nodiscard]] CastlingRights castlingRights() const { return cr_; }
@@ -2559,6 +2595,43 @@ class Board {
         return hash_key ^ ep_hash ^ stm_hash ^ castling_hash;
     }
 
+    /**
+     * @brief Calculates the zobrist hash key of the pawns, expensive! Prefer using pawnHash().
+     * @return
+     */
+    [[nodiscard]] U64 pawnZobrist() const {
+        U64 hash_key = 0ULL;
+
+        auto pawns = pieces(PieceType::PAWN);
+
+        while (pawns.getBits()) {
+            const Square sq = pawns.pop();
+            hash_key ^= Zobrist::piece(at(sq), sq);
+        }
+
+        return hash_key;
+    }
+
+    /**
+     * @brief Calculates the material zobrist hash key, expensive! Prefer using materialHash().
+     * @return
+     */
+    [[nodiscard]] U64 materialZobrist() const {
+        U64 hash_key = 0ULL;
+
+        for (const auto color : {Color::WHITE, Color::BLACK}) {
+            for (const auto type : {PieceType::PAWN, PieceType::KNIGHT, PieceType::BISHOP, PieceType::ROOK,
+                                    PieceType::QUEEN}) {
+                const auto piece = Piece(type, color);
+                const auto count = pieces(type, color).count();
+
+                for (int i = 0; i < count; i++) hash_key ^= Zobrist::piece(piece, Square(i));
+            }
+        }
+
+        return hash_key;
+    }
+
     friend std::ostream &operator<<(std::ostream &os, const Board &board);
 
     /**
@@ -2811,7 +2884,10 @@ class Board {
                 board.plies_++;
             }
 
-            board.key_ = board.zobrist();
+            board.key_      = board.zobrist();
+            board.pawn_key_ = board.pawnZobrist();
+
+            board.material_key_ = board.materialZobrist();
         }
 
         // 1:1 mapping of Piece::internal() to the compressed piece
@@ -2863,6 +2939,8 @@ class Board {
     std::array<Piece, 64> board_       = {};
 
     U64 key_           = 0ULL;
+    U64 pawn_key_      = 0ULL;
+    U64 material_key_  = 0ULL;
     CastlingRights cr_ = {};
     uint16_t plies_    = 0;
     Color stm_         = Color::WHITE;
@@ -2872,6 +2950,12 @@ class Board {
     bool chess960_ = false;
 
    private:
+    // Material key contribution of the n-th piece of a kind, where n is the current count of that
+    // piece plus offset. Called after the piece was placed or removed.
+    [[nodiscard]] U64 materialKey(Piece piece, int offset = 0) const {
+        return Zobrist::piece(piece, Square(pieces(piece.type(), piece.color()).count() + offset));
+    }
+
     void removePieceInternal(Piece piece, Square sq) {
         assert(board_[sq.index()] == piece && piece != Piece::NONE);
 
@@ -2953,6 +3037,8 @@ class Board {
         cr_.clear();
         prev_states_.clear();
 
+        pawn_key_ = 0ULL;
+
         if (stm_ == Color::BLACK) {
             plies_++;
         } else {
@@ -2976,10 +3062,13 @@ class Board {
                 }
 
                 key_ ^= Zobrist::piece(p, Square(square));
+                if (p.type() == PieceType::PAWN) pawn_key_ ^= Zobrist::piece(p, Square(square));
                 ++square;
             }
         }
 
+        material_key_ = materialZobrist();
+
         static const auto find_rook = [](const Board &board, CastlingRights::Side side, Color color) {
             const auto king_side = CastlingRights::Side::KING_SIDE;
             const auto king_sq   = board.kingSq(color);
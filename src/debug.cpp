@@ -95,6 +95,10 @@ int main() {
     std::getline(std::cin, startingFen);
     board = Board(startingFen);
 
+    if (!movePickerMatchesMovegen(board)) {
+        std::cout << "Move picker does not match the legal moves of " << board.getFen() << std::endl;
+    }
+
     // Default settings
     int depth = 30;
     int numThreads = 6;
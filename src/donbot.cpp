@@ -37,6 +37,9 @@ using namespace chess;
 const std::string ENGINE_NAME = "PIG ENGINE";
 const std::string ENGINE_AUTHOR = "Hoa T. Vu";
 
+// Number of search threads, set by the Threads option
+int searchThreads = DEFAULT_THREADS;
+
 
 std::string getBookMove(Board& board) {
     std::vector<std::string> possibleMoves;
@@ -128,7 +131,7 @@ void processSetOption(const std::string& command) {
 
     iss >> token; // Skip "setoption"
     iss >> token; // Skip "name"
-    std::getline(iss, optionName, ' ');
+    std::getline(iss >> std::ws, optionName);
 
     size_t pos = optionName.find(" value ");
     if (pos != std::string::npos) {
@@ -138,10 +141,9 @@ void processSetOption(const std::string& command) {
 
     if (optionName == "Hash") {
         int hashSize = std::stoi(value);
-        // Set hash table size
+        resizeTables(hashSize);
     } else if (optionName == "Threads") {
-        int threads = std::stoi(value);
-        // Set number of threads
+        searchThreads = std::max(1, std::stoi(value));
     } else if (optionName == "Ponder") {
         bool ponder = (value == "true");
         // Enable or disable pondering
@@ -158,7 +160,7 @@ void processGo(const std::vector<std::string>& tokens) {
 
     // Default settings
     int depth = 30;
-    int numThreads = 6;
+    int numThreads = searchThreads;
     int timeLimit = 30000; // Default to 15 seconds
     bool quiet = false;
 
@@ -232,6 +234,8 @@ void processGo(const std::vector<std::string>& tokens) {
 void processUci() {
     std::cout << "Engine's name: " << ENGINE_NAME << std::endl;
     std::cout << "Author:" << ENGINE_AUTHOR << std::endl;
+    std::cout << "option name Hash type spin default " << DEFAULT_HASH_MB << " min 1 max 65536" << std::endl;
+    std::cout << "option name Threads type spin default " << DEFAULT_THREADS << " min 1 max 256" << std::endl;
     std::cout << "uciok" << std::endl;
 }
 
@@ -248,6 +252,9 @@ void uciLoop() {
             std::cout << "readyok" << std::endl;
         } else if (line == "ucinewgame") {
             board = Board(); // Reset board to starting position
+            clearTables();
+        } else if (line.find("setoption") == 0) {
+            processSetOption(line);
         } else if (line.find("position") == 0) {
             processPosition(line);
         } else if (line.find("go") == 0) {
@@ -4,6 +4,9 @@
 #include <unordered_map>
 #include <cstdint>
 #include <map>
+#include <atomic>
+#include <memory>
+#include <limits>
 #include <omp.h> 
 
 using namespace chess; 
@@ -13,19 +16,44 @@ using namespace chess;
 ------------------------------------------------------------------------*/
 
 // Constants for the evaluation function
-const int PAWN_VALUE = 120;
-const int KNIGHT_VALUE = 320; 
-const int BISHOP_VALUE = 330;
-const int ROOK_VALUE = 500;
-const int QUEEN_VALUE = 900;
-const int KING_VALUE = 5000;
+constexpr int PAWN_VALUE = 120;
+constexpr int KNIGHT_VALUE = 320; 
+constexpr int BISHOP_VALUE = 330;
+constexpr int ROOK_VALUE = 500;
+constexpr int QUEEN_VALUE = 900;
+constexpr int KING_VALUE = 5000;
+
+// Margin for the lazy evaluation exit. The positional terms have no strict bound, but with the
+// king threat capped their total stayed below 740 on 235K positions from random games.
+constexpr int LAZY_EVAL_MARGIN = 800;
+
+// Cap on the king threat penalty, which otherwise grows with every attacker
+constexpr int KING_THREAT_CAP = 300;
+
+// Pawn hash table. Each thread owns a fixed-size table so probes never lock or allocate. 
+// A table is allocated on first use and cleared lazily once clearPawnHashTable bumps the epoch.
+const int PAWN_TABLE_SIZE = 1 << 13; // Entries per thread, must be a power of two
+thread_local std::unique_ptr<PawnEntry[]> pawnTable;
+thread_local std::uint32_t pawnTableEpoch = 0;
+std::atomic<std::uint32_t> pawnTableGlobalEpoch(1);
+
+// Material hash table, one per thread like the pawn hash table. An entry depends only on the
+// piece counts, so it never goes stale and the table is never cleared.
+const int MATERIAL_TABLE_SIZE = 1 << 12; // Entries per thread, must be a power of two
+thread_local std::unique_ptr<MaterialEntry[]> materialTable;
+
+// Evaluation cache, one per thread, mapping the Zobrist hash to the full static evaluation.
+// Lazy estimates depend on the window they were computed for and are never stored.
+struct EvalCacheEntry {
+    std::uint64_t key;
+    int eval;
+};
 
-// Pawn hash table
-std::unordered_map<std::uint64_t, std::unordered_map<std::uint64_t, int>> whitePawnHashTable;
-std::unordered_map<std::uint64_t, std::unordered_map<std::uint64_t, int>> blackPawnHashTable;
+const int EVAL_CACHE_SIZE = 1 << 15; // Entries per thread, must be a power of two
+thread_local std::unique_ptr<EvalCacheEntry[]> evalCache;
 
 // Knight piece-square tables
-const int whiteKnightTableMid[64] = {
+constexpr int knightTableMid[64] = {
     -105, -30, -58, -33, -17, -28, -30,  -90,
      -29, -53, -12,  -3,  -1,  18, -14,  -19,
      -23,  -9,  12,  10,  19,  17,  15,  -16,
@@ -36,18 +64,7 @@ const int whiteKnightTableMid[64] = {
     -167, -89, -34, -49,  61, -97, -15, -107,
 };
 
-const int blackKnightTableMid[64] = {
-    -167, -89, -34, -49,  61, -97, -15, -107,
-     -73, -41,  72,  36,  23,  62,   7,  -17,
-     -47,  60,  37,  65,  84, 129,  73,   44,
-      -9,  17,  19,  53,  37,  69,  18,   22,
-     -13,   4,  16,  13,  20,  19,  21,   -8,
-     -23,  -9,  12,  10,  19,  17,  15,  -16,
-     -29, -53, -12,  -3,  -1,  18, -14,  -19,
-    -105, -30, -58, -33, -17, -28, -30,  -90,
-};
-
-const int whiteKnightTableEnd[64] = {
+constexpr int knightTableEnd[64] = {
      -29, -51, -23, -15, -22, -18, -50,  -64,
      -42, -20, -10,  -5,  -2, -20, -23,  -44,
      -23,  -3,  -1,  15,  10,  -3, -20,  -22,
@@ -58,19 +75,8 @@ const int whiteKnightTableEnd[64] = {
      -58, -38, -13, -28, -31, -27, -63,  -99,
 };
 
-const int blackKnightTableEnd[64] = {
-     -58, -38, -13, -28, -31, -27, -63,  -99,
-     -25,  -8, -25,  -2,  -9, -25, -24,  -52,
-     -24, -20,  10,   9,  -1,  -9, -19,  -41,
-     -17,   3,  22,  22,  22,  11,   8,  -18,
-     -18,  -6,  16,  25,  16,  17,   4,  -18,
-     -23,  -3,  -1,  15,  10,  -3, -20,  -22,
-     -42, -20, -10,  -5,  -2, -20, -23,  -44,
-     -29, -51, -23, -15, -22, -18, -50,  -64,
-};
-
-// Bishop piece-square tablesint 
-const int whiteBishopTableMid[64] = {
+// Bishop piece-square tables
+constexpr int bishopTableMid[64] = {
     -33,  -3, -14, -21, -13, -12, -39, -21,
       4,  25,  16,   0,   7,  21,  33,   1,
       0,  15,  15,  15,  14,  27,  18,  10,
@@ -81,18 +87,7 @@ const int whiteBishopTableMid[64] = {
     -29,   4, -82, -37, -25, -42,   7,  -8,
 };
 
-const int blackBishopTableMid[64] = {
-    -29,   4, -82, -37, -25, -42,   7,  -8,
-    -26,  16, -18, -13,  30,  59,  18, -47,
-    -16,  37,  43,  40,  35,  50,  37,  -2,
-     -4,   5,  19,  50,  37,  37,   7,  -2,
-     -6,  13,  20,  26,  34,  20,  10,   4,
-      0,  15,  15,  15,  14,  27,  18,  10,
-      4,  25,  16,   0,   7,  21,  33,   1,
-    -33,  -3, -14, -21, -13, -12, -39, -21,
-};
-
-const int whiteBishopTableEnd[64] = {
+constexpr int bishopTableEnd[64] = {
     -23,  -9, -23,  -5,  -9, -16,  -5, -17,
     -14, -18,  -7,  -1,   4,  -9, -15, -27,
     -12,  -3,   8,  10,  13,   3,  -7, -15,
@@ -103,19 +98,8 @@ const int whiteBishopTableEnd[64] = {
     -14, -21, -11,  -8,  -7,  -9, -17, -24,
 };
 
-const int blackBishopTableEnd[64] = {
-    -14, -21, -11,  -8, -7,  -9, -17, -24,
-     -8,  -4,   7, -12, -3, -13,  -4, -14,
-      2,  -8,   0,  -1, -2,   6,   0,   4,
-     -3,   9,  12,   9, 14,  10,   3,   2,
-     -6,   3,  13,  19,  7,  10,  -3,  -9,
-    -12,  -3,   8,  10, 13,   3,  -7, -15,
-    -14, -18,  -7,  -1,  4,  -9, -15, -27,
-    -23,  -9, -23,  -5, -9, -16,  -5, -17,
-};
-
-// Pawn piece-square tables for White in the middle game
-const int whitePawnTableMid[64] = {
+// Pawn piece-square tables
+constexpr int pawnTableMid[64] = {
       0,   0,   0,   0,   0,   0,   0,   0,
     -35,  -1, -20, -35, -35,  24,  38, -22,
     -26,  -4,  3,  0,  0,   3,  33, -12,
@@ -126,19 +110,7 @@ const int whitePawnTableMid[64] = {
       0,   0,   0,   0,   0,   0,   0,   0,
 };
 
-// Pawn piece-square tables for Black in the middle game
-const int blackPawnTableMid[64] = {
-     0,   0,   0,   0,   0,   0,   0,   0,
-     98, 134,  61,  95,  68, 126,  34, -11,
-     -6,   7,  26,  31,  65,  56,  25, -20,
-    -14,  13,   6,  21,  23,  12,  17, -23,
-    -27,  -2,  5,  25,  25,   5,  10, -25,
-    -26,  -4,  3,  0,  0,   3,  33, -12,
-    -35,  -1, -20, -35, -35,  24,  38, -22,
-      0,   0,   0,   0,   0,   0,   0,   0,
-};
-
-const int whitePawnTableEnd[64] = {
+constexpr int pawnTableEnd[64] = {
       0,   0,   0,   0,   0,   0,   0,   0,
      13,   8,   8,  10,  13,   0,   2,  -7,
       4,   7,  -6,   1,   0,  -5,  -1,  -8,
@@ -149,17 +121,6 @@ const int whitePawnTableEnd[64] = {
       0,   0,   0,   0,   0,   0,   0,   0,
 };
 
-const int blackPawnTableEnd[64] = {
-      0,   0,   0,   0,   0,   0,   0,   0,
-    178, 173, 158, 134, 147, 132, 165, 187,
-     94, 100,  85,  67,  56,  53,  82,  84,
-     32,  24,  13,   5,  -2,   4,  17,  17,
-     13,   9,  -3,  -7,  -7,  -8,   3,  -1,
-      4,   7,  -6,   1,   0,  -5,  -1,  -8,
-     13,   8,   8,  10,  13,   0,   2,  -7,
-      0,   0,   0,   0,   0,   0,   0,   0,
-};
-
 int weakPawnPenaltyTable[64] = {
 	 0,   0,   0,   0,   0,   0,   0,   0,
    -10, -12, -14, -16, -16, -14, -12, -10,
@@ -171,7 +132,7 @@ int weakPawnPenaltyTable[64] = {
 	 0,   0,   0,   0,   0,   0,   0,   0
 };
 
-const int whitePassedPawnTable[64] = {
+constexpr int passedPawnTable[64] = {
 	 0,   0,   0,   0,   0,   0,   0,   0,
 	20,  20,  20,  20,  20,  20,  20,  20,
 	20,  20,  20,  20,  20,  20,  20,  20,
@@ -182,21 +143,8 @@ const int whitePassedPawnTable[64] = {
 	 0,   0,   0,   0,   0,   0,   0,   0
 };
 
-
-const int blackPassedPawnTable[64] = {
-	 0,   0,   0,   0,   0,   0,   0,   0,
-   140, 140, 140, 140, 140, 140, 140, 140,
-	92,  92,  92,  92,  92,  92,  92,  92,
-	56,  56,  56,  56,  56,  56,  56,  56,
-	32,  32,  32,  32,  32,  32,  32,  32,
-	20,  20,  20,  20,  20,  20,  20,  20,
-	20,  20,  20,  20,  20,  20,  20,  20,
-	 0,   0,   0,   0,   0,   0,   0,   0
-};
-
-
 // Rook piece-square tables
-const int whiteRookTableMid[64] = {
+constexpr int rookTableMid[64] = {
     -19, -13,   1,  17,  16,   7, -37, -26,
     -44, -16, -20,  -9,  -1,  11,  -6, -71,
     -45, -25, -16, -17,   3,   0,  -5, -33,
@@ -207,18 +155,7 @@ const int whiteRookTableMid[64] = {
      32,  42,  32,  51,  63,   9,  31,  43,
 };
 
-const int blackRookTableMid[64] = {
-     32,  42,  32,  51, 63,  9,  31,  43,
-     27,  32,  58,  62, 80, 67,  26,  44,
-     -5,  19,  26,  36, 17, 45,  61,  16,
-    -24, -11,   7,  26, 24, 35,  -8, -20,
-    -36, -26, -12,  -1,  9, -7,   6, -23,
-    -45, -25, -16, -17,  3,  0,  -5, -33,
-    -44, -16, -20,  -9, -1, 11,  -6, -71,
-    -19, -13,   1,  17, 16,  7, -37, -26,
-};
-
-const int whiteRookTableEnd[64] = {
+constexpr int rookTableEnd[64] = {
      -9,   2,   3,  -1,  -5, -13,   4, -20,
      -6,  -6,   0,   2,  -9,  -9, -11,  -3,
      -4,   0,  -5,  -1,  -7, -12,  -8, -16,
@@ -229,19 +166,8 @@ const int whiteRookTableEnd[64] = {
      13,  10,  18,  15,  12,  12,   8,   5,
 };
 
-const int blackRookTableEnd[64] = {
-    13, 10, 18, 15, 12,  12,   8,   5,
-    11, 13, 13, 11, -3,   3,   8,   3,
-     7,  7,  7,  5,  4,  -3,  -5,  -3,
-     4,  3, 13,  1,  2,   1,  -1,   2,
-     3,  5,  8,  4, -5,  -6,  -8, -11,
-    -4,  0, -5, -1, -7, -12,  -8, -16,
-    -6, -6,  0,  2, -9,  -9, -11,  -3,
-    -9,  2,  3, -1, -5, -13,   4, -20,
-};
-
 // Queen piece-square tables
-const int whiteQueenTableMid[64] = {
+constexpr int queenTableMid[64] = {
      -1, -18,  -9,  10, -15, -25, -31, -50,
     -35,  -8,  11,   2,   8,  15,  -3,   1,
     -14,   2, -11,  -2,  -5,   2,  14,   5,
@@ -252,18 +178,7 @@ const int whiteQueenTableMid[64] = {
     -28,   0,  29,  12,  59,  44,  43,  45,
 };
 
-const int blackQueenTableMid[64] = {
-    -28,   0,  29,  12,  59,  44,  43,  45,
-    -24, -39,  -5,   1, -16,  57,  28,  54,
-    -13, -17,   7,   8,  29,  56,  47,  57,
-    -27, -27, -16, -16,  -1,  17,  -2,   1,
-     -9, -26,  -9, -10,  -2,  -4,   3,  -3,
-    -14,   2, -11,  -2,  -5,   2,  14,   5,
-    -35,  -8,  11,   2,   8,  15,  -3,   1,
-     -1, -18,  -9,  10, -15, -25, -31, -50,
-};
-
-const int whiteQueenTableEnd[64] = {
+constexpr int queenTableEnd[64] = {
     -33, -28, -22, -43,  -5, -32, -20, -41,
     -22, -23, -30, -16, -16, -23, -36, -32,
     -16, -27,  15,   6,   9,  17,  10,   5,
@@ -274,19 +189,7 @@ const int whiteQueenTableEnd[64] = {
      -9,  22,  22,  27,  27,  19,  10,  20,
 };
 
-
-const int blackQueenTableEnd[64] = {
-     -9,  22,  22,  27,  27,  19,  10,  20,
-    -17,  20,  32,  41,  58,  25,  30,   0,
-    -20,   6,   9,  49,  47,  35,  19,   9,
-      3,  22,  24,  45,  57,  40,  57,  36,
-    -18,  28,  19,  47,  31,  34,  39,  23,
-    -16, -27,  15,   6,   9,  17,  10,   5,
-    -22, -23, -30, -16, -16, -23, -36, -32,
-    -33, -28, -22, -43,  -5, -32, -20, -41,
-};
-
-const int whiteKingTableMid[64] = {
+constexpr int kingTableMid[64] = {
     -15,  35,  25, -54,  -5, -28,  35,  14,
       1,   7,  -8, -64, -43, -16,   9,   8,
     -14, -14, -22, -46, -44, -30, -15, -27,
@@ -297,18 +200,7 @@ const int whiteKingTableMid[64] = {
     -65,  23,  16, -15, -56, -34,   2,  13,
 };
 
-const int blackKingTableMid[64] = {
-    -65,  23,  16, -15, -56, -34,   2,  13,
-     29,  -1, -20,  -7,  -8,  -4, -38, -29,
-     -9,  24,   2, -16, -20,   6,  22, -22,
-    -17, -20, -12, -27, -30, -25, -14, -36,
-    -49,  -1, -27, -39, -46, -44, -33, -51,
-    -14, -14, -22, -46, -44, -30, -15, -27,
-      1,   7,  -8, -64, -43, -16,   9,   8,
-    -15,  35,  25, -54, -5, -28,  35,   14,
-};
-
-const int whiteKingTableEnd[64] = {
+constexpr int kingTableEnd[64] = {
     -53, -34, -21, -11, -28, -14, -24, -43,
     -27, -11,   4,  13,  14,   4,  -5, -17,
     -19,  -3,  11,  21,  23,  16,   7,  -9,
@@ -319,84 +211,29 @@ const int whiteKingTableEnd[64] = {
     -74, -35, -18, -18, -11,  15,   4, -17,
 };
 
-const int blackKingTableEnd[64] = {
-    -74, -35, -18, -18, -11,  15,   4, -17,
-    -12,  17,  14,  17,  17,  38,  23,  11,
-     10,  17,  23,  15,  20,  45,  44,  13,
-     -8,  22,  24,  27,  26,  33,  26,   3,
-    -18,  -4,  21,  24,  27,  23,   9, -11,
-    -19,  -3,  11,  21,  23,  16,   7,  -9,
-    -27, -11,   4,  13,  14,   4,  -5, -17,
-    -53, -34, -21, -11, -28, -14, -24, -43
+// Piece-square tables including the base piece values, indexed by [color][piece type][square].
+// Only the white tables are written out, the black half is mirrored from them at compile time.
+struct PieceSquareTable {
+    Score score[2][6][64];
 };
 
-const std::unordered_map<int, std::vector<int>> adjSquares = {
-    {0, {1, 8, 9}}, 
-    {1, {0, 2, 8, 9, 10}}, 
-    {2, {1, 3, 9, 10, 11}}, 
-    {3, {2, 4, 10, 11, 12}}, 
-    {4, {3, 5, 11, 12, 13}}, 
-    {5, {4, 6, 12, 13, 14}}, 
-    {6, {5, 7, 13, 14, 15}}, 
-    {7, {6, 14, 15}}, 
-    {8, {0, 1, 9, 16, 17}}, 
-    {9, {0, 1, 2, 8, 10, 16, 17, 18}}, 
-    {10, {1, 2, 3, 9, 11, 17, 18, 19}}, 
-    {11, {2, 3, 4, 10, 12, 18, 19, 20}}, 
-    {12, {3, 4, 5, 11, 13, 19, 20, 21}}, 
-    {13, {4, 5, 6, 12, 14, 20, 21, 22}}, 
-    {14, {5, 6, 7, 13, 15, 21, 22, 23}}, 
-    {15, {6, 7, 14, 22, 23}}, 
-    {16, {8, 9, 17, 24, 25}}, 
-    {17, {8, 9, 10, 16, 18, 24, 25, 26}}, 
-    {18, {9, 10, 11, 17, 19, 25, 26, 27}}, 
-    {19, {10, 11, 12, 18, 20, 26, 27, 28}}, 
-    {20, {11, 12, 13, 19, 21, 27, 28, 29}}, 
-    {21, {12, 13, 14, 20, 22, 28, 29, 30}}, 
-    {22, {13, 14, 15, 21, 23, 29, 30, 31}}, 
-    {23, {14, 15, 22, 30, 31}}, 
-    {24, {16, 17, 25, 32, 33}}, 
-    {25, {16, 17, 18, 24, 26, 32, 33, 34}}, 
-    {26, {17, 18, 19, 25, 27, 33, 34, 35}}, 
-    {27, {18, 19, 20, 26, 28, 34, 35, 36}}, 
-    {28, {19, 20, 21, 27, 29, 35, 36, 37}}, 
-    {29, {20, 21, 22, 28, 30, 36, 37, 38}}, 
-    {30, {21, 22, 23, 29, 31, 37, 38, 39}}, 
-    {31, {22, 23, 30, 38, 39}}, 
-    {32, {24, 25, 33, 40, 41}}, 
-    {33, {24, 25, 26, 32, 34, 40, 41, 42}}, 
-    {34, {25, 26, 27, 33, 35, 41, 42, 43}}, 
-    {35, {26, 27, 28, 34, 36, 42, 43, 44}}, 
-    {36, {27, 28, 29, 35, 37, 43, 44, 45}}, 
-    {37, {28, 29, 30, 36, 38, 44, 45, 46}}, 
-    {38, {29, 30, 31, 37, 39, 45, 46, 47}}, 
-    {39, {30, 31, 38, 46, 47}}, 
-    {40, {32, 33, 41, 48, 49}}, 
-    {41, {32, 33, 34, 40, 42, 48, 49, 50}}, 
-    {42, {33, 34, 35, 41, 43, 49, 50, 51}}, 
-    {43, {34, 35, 36, 42, 44, 50, 51, 52}}, 
-    {44, {35, 36, 37, 43, 45, 51, 52, 53}}, 
-    {45, {36, 37, 38, 44, 46, 52, 53, 54}}, 
-    {46, {37, 38, 39, 45, 47, 53, 54, 55}}, 
-    {47, {38, 39, 46, 54, 55}}, 
-    {48, {40, 41, 49, 56, 57}}, 
-    {49, {40, 41, 42, 48, 50, 56, 57, 58}}, 
-    {50, {41, 42, 43, 49, 51, 57, 58, 59}}, 
-    {51, {42, 43, 44, 50, 52, 58, 59, 60}}, 
-    {52, {43, 44, 45, 51, 53, 59, 60, 61}}, 
-    {53, {44, 45, 46, 52, 54, 60, 61, 62}}, 
-    {54, {45, 46, 47, 53, 55, 61, 62, 63}}, 
-    {55, {46, 47, 54, 62, 63}}, 
-    {56, {48, 49, 57}}, 
-    {57, {48, 49, 50, 56, 58}}, 
-    {58, {49, 50, 51, 57, 59}}, 
-    {59, {50, 51, 52, 58, 60}}, 
-    {60, {51, 52, 53, 59, 61}}, 
-    {61, {52, 53, 54, 60, 62}}, 
-    {62, {53, 54, 55, 61, 63}}, 
-    {63, {54, 55, 62}}
-};
+constexpr PieceSquareTable makePieceSquareTable() {
+    const int baseValues[6] = {PAWN_VALUE, KNIGHT_VALUE, BISHOP_VALUE, ROOK_VALUE, QUEEN_VALUE, KING_VALUE};
+    const int* midTables[6] = {pawnTableMid, knightTableMid, bishopTableMid, rookTableMid, queenTableMid, kingTableMid};
+    const int* endTables[6] = {pawnTableEnd, knightTableEnd, bishopTableEnd, rookTableEnd, queenTableEnd, kingTableEnd};
+
+    PieceSquareTable table = {};
+    for (int piece = 0; piece < 6; piece++) {
+        for (int sq = 0; sq < 64; sq++) {
+            Score score = makeScore(baseValues[piece] + midTables[piece][sq], baseValues[piece] + endTables[piece][sq]);
+            table.score[0][piece][sq] = score;
+            table.score[1][piece][sq ^ 56] = score;
+        }
+    }
+    return table;
+}
 
+alignas(64) constexpr PieceSquareTable pieceSquareTable = makePieceSquareTable();
 
 const Bitboard a1 = Bitboard::fromSquare(0);
 const Bitboard b1 = Bitboard::fromSquare(1);
@@ -503,10 +340,35 @@ int materialImbalance(const Board& board) {
     return whiteMaterial - blackMaterial;
 }
 
-// Clear the pawn hash table
+// Recompute the material and piece-square sums from scratch
+void EvalBoard::refreshScores() {
+    psqScore_[0] = 0;
+    psqScore_[1] = 0;
+
+    Bitboard occupied = occ();
+    while (occupied) {
+        int sqIndex = occupied.pop();
+        int piece = static_cast<int>(at(Square(sqIndex)).internal());
+
+        psqScore_[piece / 6] += pieceSquareTable.score[piece / 6][piece % 6][sqIndex];
+    }
+}
+
+void EvalBoard::placePiece(Piece piece, Square sq) {
+    Board::placePiece(piece, sq);
+    int index = static_cast<int>(piece.internal());
+    psqScore_[index / 6] += pieceSquareTable.score[index / 6][index % 6][sq.index()];
+}
+
+void EvalBoard::removePiece(Piece piece, Square sq) {
+    Board::removePiece(piece, sq);
+    int index = static_cast<int>(piece.internal());
+    psqScore_[index / 6] -= pieceSquareTable.score[index / 6][index % 6][sq.index()];
+}
+
+// Clear the pawn hash tables of all threads. Each table is wiped on its next probe.
 void clearPawnHashTable() {
-    whitePawnHashTable = {};
-    blackPawnHashTable = {};
+    pawnTableGlobalEpoch.fetch_add(1, std::memory_order_relaxed);
 }
 
 //End game special heuristics to avoid illusory material advantage.
@@ -609,26 +471,6 @@ void bitBoardVisualize(const Bitboard& board) {
     std::cout << std::endl;
 }
 
-// Generate a bitboard mask for the specified file.
-Bitboard generateFileMask(int file) {
-    constexpr Bitboard fileMasks[] = {
-        0x0101010101010101ULL, // File A
-        0x0202020202020202ULL, // File B
-        0x0404040404040404ULL, // File C
-        0x0808080808080808ULL, // File D
-        0x1010101010101010ULL, // File E
-        0x2020202020202020ULL, // File F
-        0x4040404040404040ULL, // File G
-        0x8080808080808080ULL  // File H
-    };
-
-    if (file >= 0 && file < 8) {
-        return Bitboard(fileMasks[file]);
-    }
-    
-    return Bitboard(0ULL);
-}
-
 // Generate a bitboard mask for the specified rank.
 constexpr Bitboard generateHalfMask(int startRank, int endRank) {
     Bitboard mask = 0ULL;
@@ -642,6 +484,21 @@ constexpr Bitboard generateHalfMask(int startRank, int endRank) {
 }
 
 
+// Bitboard shifts for pawn structure, the east and west shifts drop squares that wrap around.
+constexpr std::uint64_t FILE_A_BITS = 0x0101010101010101ULL;
+constexpr std::uint64_t FILE_H_BITS = 0x8080808080808080ULL;
+constexpr std::uint64_t CENTER_FILES_BITS = 0x1818181818181818ULL; // Files d and e
+
+// Ranks whose index has bit 0, 1 or 2 set, to sum the ranks of a set of squares with popcounts
+constexpr std::uint64_t RANK_INDEX_BITS[3] = {0xFF00FF00FF00FF00ULL, 0xFFFF0000FFFF0000ULL, 0xFFFFFFFF00000000ULL};
+
+inline std::uint64_t northFill(std::uint64_t b) { b |= b << 8; b |= b << 16; b |= b << 32; return b; }
+inline std::uint64_t southFill(std::uint64_t b) { b |= b >> 8; b |= b >> 16; b |= b >> 32; return b; }
+inline std::uint64_t eastOne(std::uint64_t b) { return (b << 1) & ~FILE_A_BITS; }
+inline std::uint64_t westOne(std::uint64_t b) { return (b >> 1) & ~FILE_H_BITS; }
+inline std::uint64_t flipRanks(std::uint64_t b) { return __builtin_bswap64(b); }
+inline int popCount(std::uint64_t b) { return Bitboard(b).count(); }
+
 // Check if the given square is a passed pawn
 bool isPassedPawn(int sqIndex, Color color, const Bitboard& theirPawns) {
     int file = sqIndex % 8;
@@ -678,49 +535,6 @@ int minDistance(const Square& sq, const Square& sq2) {
     return std::min(std::abs(sq.file() - sq2.file()), std::abs(sq.rank() - sq2.rank()));
 }
 
-// Check if a square is an outpost
-bool isOutpost(const Board& board, int sqIndex, Color color) {
-    int file = sqIndex % 8, rank = sqIndex / 8;
-    bool isWhite = color == Color::WHITE;
-
-    // Outposts must be in the opponent's half of the board
-    if ((isWhite && rank < 4) || (!isWhite && rank > 3)) {
-        return false;
-    }
-
-    Bitboard ourPawns = board.pieces(PieceType::PAWN, color);
-    Bitboard theirPawns = board.pieces(PieceType::PAWN, !color);
-
-    // Check for support from our pawns
-    int frontRank = (isWhite) ? rank - 1 : rank + 1;
-    Bitboard supportMask = (file > 0 ? (1ULL << (frontRank * 8 + file - 1)) : 0) |
-                           (file < 7 ? (1ULL << (frontRank * 8 + file + 1)) : 0);
-
-    if (!(ourPawns & supportMask)) {
-        return false; 
-    }
-
-    // Check for potential attack from opponent pawns
-    for (int r = rank + 1; r < 8 && isWhite; ++r) {
-        if (file > 0 && (theirPawns & (1ULL << (r * 8 + file - 1)))) {
-            return false; 
-        }
-        if (file < 7 && (theirPawns & (1ULL << (r * 8 + file + 1)))) {
-            return false; 
-        }
-    }
-    for (int r = rank - 1; r >= 0 && !isWhite; --r) {
-        if (file > 0 && (theirPawns & (1ULL << (r * 8 + file - 1)))) {
-            return false; 
-        }
-        if (file < 7 && (theirPawns & (1ULL << (r * 8 + file + 1)))) {
-            return false; 
-        }
-    }
-
-    return true;
-}
-
 Bitboard allPieces(const Board& board, Color color) {
     // Return a bitboard with all pieces of the given color except kings
     return board.pieces(PieceType::PAWN, color) | board.pieces(PieceType::KNIGHT, color) 
@@ -728,131 +542,126 @@ Bitboard allPieces(const Board& board, Color color) {
            | board.pieces(PieceType::QUEEN, color) | board.pieces(PieceType::KING, color);
 }
 
-bool isOpenFile(const Board& board, int file) {
-    // Get bitboards for white and black pawns
-    Bitboard whitePawns = board.pieces(PieceType::PAWN, Color::WHITE);
-    Bitboard blackPawns = board.pieces(PieceType::PAWN, Color::BLACK);
-    Bitboard mask = generateFileMask(File(file));
+/*------------------------------------------------------------------------
+ Main Functions 
+------------------------------------------------------------------------*/
 
-    return !(whitePawns & mask) && !(blackPawns & mask);
-}
+/*------------------------------------------------------------------------
+Mop-up evaluation when the losing side has only its king left. Drive their
+king to the edge and bring our king closer.
+------------------------------------------------------------------------*/
+int mopUpValue(const Board& board, Color winningColor) {
+    Square winningKingSq = Square(board.pieces(PieceType::KING, winningColor).lsb());
+    Square losingKingSq = Square(board.pieces(PieceType::KING, !winningColor).lsb());
+    Square E4 = Square(28);
 
-bool isSemiOpenFile(const Board& board, int file, Color color) {
-    Bitboard ownPawns = board.pieces(PieceType::PAWN, color);
-    Bitboard mask = generateFileMask(File(file));
-    return !(ownPawns & mask);
-}
+    int kingDist = manhattanDistance(winningKingSq, losingKingSq);
+    int distToCenter = manhattanDistance(losingKingSq, E4);
+    int score = 5000 +  500 * distToCenter + 150 * (14 - kingDist);
 
-bool isProtected(const Board& board, Color color, int sqIndex) {
-    // Get the file and rank of the square
-    Bitboard protectors = attacks::attackers(board, color, Square(sqIndex));
-    if (protectors) {
-        return true;
-    } else {
-        return false;
-    }
+    return winningColor == Color::WHITE ? score : -score;
 }
 
-bool isProtectedByPawn(int sqIndex, const Board& board, Color color) {
-    // Get the file and rank of the square
-    int file = sqIndex % 8;
-    int rank = sqIndex / 8;
-
-    if (color == Color::WHITE) {
-        if (rank == 0) {
-            return false;
-        }
-        if (file > 0 && board.at(Square((rank - 1) * 8 + (file - 1))) == PieceType::PAWN
-            && board.at(Square((rank - 1) * 8 + (file - 1))).color() == Color::WHITE) {
-            return true; 
-        }
-        if (file < 7 && board.at(Square((rank - 1) * 8 + (file + 1))) == PieceType::PAWN
-            && board.at(Square((rank - 1) * 8 + (file + 1))).color() == Color::WHITE) {
-            return true;
-        }
-    }
-    else {
-        if (rank == 7) {
-            return false;
-        }
-        if (file > 0 && board.at(Square((rank + 1) * 8 + (file - 1))) == PieceType::PAWN
-            && board.at(Square((rank + 1) * 8 + (file - 1))).color() == Color::BLACK) {
-            return true; 
-        }
-        if (file < 7 && board.at(Square((rank + 1) * 8 + (file + 1))) == PieceType::PAWN
-            && board.at(Square((rank + 1) * 8 + (file + 1))).color() == Color::BLACK) {
-            return true;
+/*------------------------------------------------------------------------
+Return the slot of this thread's evaluation cache for the given hash, 
+allocating the cache on first use.
+------------------------------------------------------------------------*/
+EvalCacheEntry& evalCacheSlot(std::uint64_t key) {
+    if (!evalCache) {
+        evalCache.reset(new EvalCacheEntry[EVAL_CACHE_SIZE]);
+        for (int i = 0; i < EVAL_CACHE_SIZE; i++) {
+            evalCache[i].key = ~0ULL;
         }
     }
-
-    return false; // No protecting pawn found
+    return evalCache[key & (EVAL_CACHE_SIZE - 1)];
 }
 
-// check if a squared is opposed by an enemy pawn
-bool isOpposed(int sqIndex, const Board& board, Color color) {
-    int file = sqIndex % 8;
-    int rank = sqIndex / 8;
+/*------------------------------------------------------------------------
+Look up the material configuration of the board in this thread's material
+hash table, computing and storing it on a miss. This replaces the piece 
+counting that knownDraw, gamePhase and materialImbalance do on every call.
+------------------------------------------------------------------------*/
+const MaterialEntry& probeMaterialTable(const Board& board) {
 
-    if (color == Color::WHITE) {
-        if (board.at(Square((rank + 1) * 8 + file)) == PieceType::PAWN
-            && board.at(Square((rank + 1) * 8 + file)).color() == Color::BLACK) {
-            return true;
-        }
-    }
-    else {
-        if (board.at(Square((rank - 1) * 8 + file)) == PieceType::PAWN
-            && board.at(Square((rank - 1) * 8 + file)).color() == Color::WHITE) {
-            return true;
+    if (!materialTable) {
+        materialTable.reset(new MaterialEntry[MATERIAL_TABLE_SIZE]);
+        // Key 0 is the key of bare kings, so empty slots use a different value
+        for (int i = 0; i < MATERIAL_TABLE_SIZE; i++) {
+            materialTable[i].key = ~0ULL;
         }
     }
 
-    return false; // No opposing pawn found
-}
-
-
-/*------------------------------------------------------------------------
- Main Functions 
-------------------------------------------------------------------------*/
+    std::uint64_t key = board.materialHash();
+    MaterialEntry& entry = materialTable[key & (MATERIAL_TABLE_SIZE - 1)];
+    if (entry.key == key) {
+        return entry;
+    }
 
+    entry.gamePhase = std::min(gamePhase(board), 24);
+    entry.imbalance = materialImbalance(board);
+    entry.draw = knownDraw(board);
+    entry.endgame = nullptr;
+    entry.strongSide = Color::WHITE;
 
-/*------------------------------------------------------------------------
-Compute the value of the pawns on the board. This is an expensive function
-so we use a hash table to store the pawn structure values for each side 
-along with the evaluation value.
+    // Mop-up phase: if only their king is left without any other pieces, aim to checkmate
+    bool whiteBare = board.us(Color::WHITE).count() == 1;
+    bool blackBare = board.us(Color::BLACK).count() == 1;
+    if (whiteBare != blackBare) {
+        entry.endgame = mopUpValue;
+        entry.strongSide = whiteBare ? Color::BLACK : Color::WHITE;
+    }
 
-This reduces the amount of computation by at least a half based on experiments.
-------------------------------------------------------------------------*/
-int pawnValue(const Board& board, int baseValue, Color color, Info& info) {
+    /*--------------------------------------------------------------------------
+        Add a penalty for piece-material deficit. At the beginning, the deficit is 24 * 2 = 48.
+        As the game progresses, the penalty decreases. 
+        This is useful to avoid trading pieces for pawns early on.
+    -------------------------------------------------------------------------*/
+    const int knightValue = 3, bishopValue = 3, rookValue = 5, queenValue = 9, pawnValue = 1;
+    int pieceValue[2];
+    int material[2];
 
-    Bitboard ourPawns = board.pieces(PieceType::PAWN, color);
-    Bitboard theirPawns = board.pieces(PieceType::PAWN, !color);
-    std::uint64_t ourPawnsBits = ourPawns.getBits();
-    std::uint64_t theirPawnsBits = theirPawns.getBits();
+    for (int color = 0; color < 2; color++) {
+        pieceValue[color] = queenValue * board.pieces(PieceType::QUEEN, Color(color)).count() 
+                        + rookValue * board.pieces(PieceType::ROOK, Color(color)).count() 
+                        + bishopValue * board.pieces(PieceType::BISHOP, Color(color)).count() 
+                        + knightValue * board.pieces(PieceType::KNIGHT, Color(color)).count();
+        material[color] = pieceValue[color] + pawnValue * board.pieces(PieceType::PAWN, Color(color)).count();
+        entry.deficitPenalty[color] = 0;
+    }
 
-    // Select the appropriate pawn hash table based on color
-    auto& pawnHashTable = (color == Color::WHITE) ? whitePawnHashTable : blackPawnHashTable;
-    bool found = false;
-    int storedValue = 0;
+    int pieceDeficitPenalty = entry.gamePhase * 5;
     
-    #pragma omp critical
-    {
-        // Check if the pawn structure value is already stored
-        auto itOuter = pawnHashTable.find(ourPawnsBits);
-        if (itOuter != pawnHashTable.end()) {
-            auto itInner = itOuter->second.find(theirPawnsBits);
-            if (itInner != itOuter->second.end()) {
-                found = true;
-                storedValue = itInner->second;
-            }
-        }
+    if (pieceValue[0] < pieceValue[1]) {
+        entry.deficitPenalty[0] += pieceDeficitPenalty;
+    } else if (pieceValue[1] < pieceValue[0]) {
+        entry.deficitPenalty[1] += pieceDeficitPenalty;
     }
 
-    if (found) {
-        return storedValue;
+    /*--------------------------------------------------------------------------
+        Add a penalty for material deficit to make sure the position advantage is real.
+    --------------------------------------------------------------------------*/
+    const int deficitPenalty = 50;
+
+    if (material[0] < material[1]) {
+        entry.deficitPenalty[0] += deficitPenalty;
+    } else if (material[1] < material[0]) {
+        entry.deficitPenalty[1] += deficitPenalty;
     }
 
-    double midGameWeight = info.gamePhase / 24.0;
-    double endGameWeight = 1.0 - midGameWeight;
+    entry.key = key;
+    return entry;
+}
+
+
+/*------------------------------------------------------------------------
+Compute the pawn structure score of one side without the base pawn values 
+and piece-square tables. Each feature is a bitboard of the pawns that have 
+it, built with shifts and fills over all pawns at once, and scored with a 
+popcount; only passed pawns are visited one by one for their rank bonus.
+Everything here depends only on the pawns, so the result is cached in the 
+pawn hash table as a packed score, so it does not depend on the game phase.
+------------------------------------------------------------------------*/
+void pawnStructure(PawnEntry& entry, Color color, std::uint64_t pawns) {
 
     // constants
     const int passedPawnBonus = 35;
@@ -861,125 +670,227 @@ int pawnValue(const Board& board, int baseValue, Color color, Info& info) {
 
     const int isolatedPawnPenalty = 20;
     const int unSupportedPenalty = 25;
+    const int backwardPawnPenalty = 10;
+
+    const int doubledPawnPenalty = 30;
+    const int doubledPawnPenaltyDE = 40;
+    const int doubleIsolatedPenalty = 30;
+
+    // The pawn advancement bonus goes from 2 per rank in the middle game to 6 in the end game
+    const int advancedPawnBonusMid = 2;
+    const int advancedPawnBonusEnd = 6;
+
+    bool isWhite = color == Color::WHITE;
+    std::uint64_t files = southFill(northFill(pawns));
+    std::uint64_t theirFiles = entry.pawnFiles[!color] * FILE_A_BITS;
+    std::uint64_t neighbours = eastOne(pawns) | westOne(pawns);
+
+    std::uint64_t supported = pawns & entry.pawnAttacks[color];
+    std::uint64_t unsupported = pawns & ~entry.pawnAttacks[color];
+    std::uint64_t isolated = pawns & ~(eastOne(files) | westOne(files));
+
+    // Pawns with another of our pawns behind them on the same file
+    std::uint64_t doubled = pawns & (isWhite ? northFill(pawns << 8) : southFill(pawns >> 8));
+
+    // Pawns no neighbour can advance to protect, with the square in front attacked by an enemy pawn
+    std::uint64_t defendable = isWhite ? northFill(neighbours) : southFill(neighbours);
+    std::uint64_t stopAttacked = isWhite ? entry.pawnAttacks[!color] >> 8 : entry.pawnAttacks[!color] << 8;
+    std::uint64_t backward = pawns & ~defendable & ~isolated & stopAttacked;
 
-    int files[8] = {0};
     int value = 0;
 
-    // Interpolate the pawn advancement bonus based on the game phase
-    int advancedPawnBonus = static_cast<int>(- (1.0 / 6.0) * info.gamePhase + 6.0);;
+    value += centerBonus * popCount(pawns & CENTER_FILES_BITS);
+    value -= isolatedPawnPenalty * popCount(isolated);
+    value -= backwardPawnPenalty * popCount(backward);
 
-    Bitboard theirPieces = board.pieces(PieceType::BISHOP, !color) 
-                            | board.pieces(PieceType::KNIGHT, !color) 
-                            | board.pieces(PieceType::ROOK, !color) 
-                            | board.pieces(PieceType::QUEEN, !color); 
-                            
-    Bitboard ourPawnsCopy = ourPawns;
-    while (!ourPawns.empty()) {
-        int sqIndex = ourPawns.lsb(); 
-        int file = sqIndex % 8; // Get the file of the pawn
-        files[file]++; // Increment the count of pawns on the file
-        ourPawns.clear(sqIndex);
+    // Add penalty for unsupported pawns, more if the opponent has no pawn on the file
+    value -= unSupportedPenalty * popCount(unsupported & ~theirFiles);
+    value -= (unSupportedPenalty - 15) * popCount(unsupported & theirFiles);
+
+    // Add penalty for doubled pawns, with an extra penalty for a doubled file next to a file without our pawns
+    value -= doubledPawnPenaltyDE * popCount(doubled & CENTER_FILES_BITS);
+    value -= doubledPawnPenalty * popCount(doubled & ~CENTER_FILES_BITS);
+
+    // The doubled pawn penalties are tuned as (pawns on the file - 1) over all files, so a file
+    // without our pawns counts as minus one doubled pawn
+    std::uint8_t emptyFiles = ~entry.pawnFiles[color];
+    std::uint8_t centerFiles = static_cast<std::uint8_t>(CENTER_FILES_BITS);
+    value += doubledPawnPenaltyDE * popCount(emptyFiles & centerFiles);
+    value += doubledPawnPenalty * popCount(emptyFiles & ~centerFiles & 0xFF);
+
+    std::uint8_t doubledFiles = static_cast<std::uint8_t>(southFill(northFill(doubled)));
+    std::uint8_t emptyNeighbourFiles = static_cast<std::uint8_t>((emptyFiles << 1) | (emptyFiles >> 1));
+    value -= doubleIsolatedPenalty * popCount(doubledFiles & emptyNeighbourFiles);
+
+    // Add bonus for passed pawns, especially if they are protected
+    std::uint64_t passed = entry.passedPawns[color];
+    value += protectedPassedPawnBonus * popCount(passed & supported);
+    value += passedPawnBonus * popCount(passed & ~supported);
+
+    while (passed) {
+        int sqIndex = __builtin_ctzll(passed);
+        value += passedPawnTable[isWhite ? sqIndex : sqIndex ^ 56];
+        passed &= passed - 1;
     }
-    ourPawns = ourPawnsCopy;
 
-    while (!ourPawns.empty()) {
-        int sqIndex = ourPawns.lsb(); 
-        bool isolated = false;
+    // Bonus for advanced pawns, more if we are in the endgame. A pawn advances one less than its relative rank.
+    std::uint64_t relative = isWhite ? pawns : flipRanks(pawns);
+    int advance = popCount(relative & RANK_INDEX_BITS[0]) + 2 * popCount(relative & RANK_INDEX_BITS[1]) 
+                + 4 * popCount(relative & RANK_INDEX_BITS[2]) - popCount(pawns);
 
-        value += baseValue; 
-        if (color == Color::WHITE) {
-            value += static_cast<int>(midGameWeight * whitePawnTableMid[sqIndex] + endGameWeight * whitePawnTableEnd[sqIndex]);
-        } else {
-            value += static_cast<int>(midGameWeight * blackPawnTableMid[sqIndex] + endGameWeight * blackPawnTableEnd[sqIndex]);
-        }
+    entry.score[color] = makeScore(value + advance * advancedPawnBonusMid, value + advance * advancedPawnBonusEnd);
+}
 
-        int file = sqIndex % 8;
-        int rank = sqIndex / 8;
+/*------------------------------------------------------------------------
+Look up the pawn structure of the board in this thread's pawn hash table, 
+computing and storing it on a miss. The returned entry stays valid until 
+the next probe from the same thread.
+------------------------------------------------------------------------*/
+const PawnEntry& probePawnTable(const Board& board) {
 
-        if (file == 3 || file == 4) {
-            value += centerBonus;
+    std::uint32_t epoch = pawnTableGlobalEpoch.load(std::memory_order_relaxed);
+    if (!pawnTable || pawnTableEpoch != epoch) {
+        if (!pawnTable) {
+            pawnTable.reset(new PawnEntry[PAWN_TABLE_SIZE]);
         }
-
-        // If the pawn is isolated, add a penalty
-        if ((file == 0 && files[1] == 0) || (file == 7 && files[6] == 0)) {
-            isolated = true;
-            value -= isolatedPawnPenalty;
-        } else if (file > 0 && file < 7 && files[file - 1] == 0  && files[file + 1] == 0) {
-            isolated = true;
-            value -= isolatedPawnPenalty;
+        // Key 0 is the key of a board without pawns, so empty slots use a different value
+        for (int i = 0; i < PAWN_TABLE_SIZE; i++) {
+            pawnTable[i].key = ~0ULL;
         }
+        pawnTableEpoch = epoch;
+    }
 
-        // Add bonus for passed pawns, especially if they are protected
-        if (isPassedPawn(sqIndex, color, theirPawns)) {
-            if (isProtectedByPawn(sqIndex, board, color)) {
-                value += protectedPassedPawnBonus;
-            } else {            
-                value += passedPawnBonus;
-            }
+    std::uint64_t key = board.pawnHash();
+    PawnEntry& entry = pawnTable[key & (PAWN_TABLE_SIZE - 1)];
+    if (entry.key == key) {
+        return entry;
+    }
 
-            if (color == Color::WHITE) {
-                value += whitePassedPawnTable[sqIndex];
-            } else {
-                value += blackPassedPawnTable[sqIndex];
-            }
-        }  
-        
-        // Add penalty for unsupported pawns, more if they are on semi-open files or open files
-        if (!isProtectedByPawn(sqIndex, board, color)) {
-            if (color == Color::WHITE && info.semiOpenFilesBlack[file]) {
-                value -= unSupportedPenalty;
-            } else if (color == Color::BLACK && info.semiOpenFilesWhite[file]) {
-                value -= unSupportedPenalty;
-            } else  {
-                value -= (unSupportedPenalty - 15); 
-            }
-        }
+    std::uint64_t pawns[2] = {board.pieces(PieceType::PAWN, Color::WHITE).getBits(), 
+                              board.pieces(PieceType::PAWN, Color::BLACK).getBits()};
+    std::uint64_t frontSpans[2] = {northFill(pawns[0] << 8), southFill(pawns[1] >> 8)};
+    std::uint64_t pushes[2] = {pawns[0] << 8, pawns[1] >> 8};
 
-        // Bonus for advanced pawns, more if we are in the endgame
-        if (color == Color::WHITE) {
-            value += (rank - 1) * advancedPawnBonus;
-        } else {
-            value += (6 - rank) * advancedPawnBonus;
-        }
+    for (int color = 0; color < 2; color++) {
+        entry.pawnAttacks[color] = eastOne(pushes[color]) | westOne(pushes[color]);
+        entry.attackSpans[color] = eastOne(frontSpans[color]) | westOne(frontSpans[color]);
+        entry.pawnFiles[color] = static_cast<std::uint8_t>(southFill(northFill(pawns[color])));
+    }
+
+    // A pawn is passed if no enemy pawn is in front of it on the same or an adjacent file
+    for (int color = 0; color < 2; color++) {
+        entry.passedPawns[color] = pawns[color] & ~(frontSpans[color ^ 1] | entry.attackSpans[color ^ 1]);
+    }
+
+    pawnStructure(entry, Color::WHITE, pawns[0]);
+    pawnStructure(entry, Color::BLACK, pawns[1]);
+    entry.key = key;
+
+    return entry;
+}
 
+/*------------------------------------------------------------------------
+Compute the pawn structure value of the pawns on the board. The structure 
+comes from the pawn hash table probed by evaluate.
+------------------------------------------------------------------------*/
+Score pawnValue(Color color, Info& info) {
+    return info.pawnEntry->score[color];
+}
 
-        ourPawns.clear(sqIndex);
+// Check if a square is an outpost using the cached pawn data: in the opponent's half, 
+// protected by our pawns and out of reach of their pawns
+bool isOutpost(const PawnEntry& entry, int sqIndex, Color color) {
+    int rank = sqIndex / 8;
+    if ((color == Color::WHITE && rank < 4) || (color == Color::BLACK && rank > 3)) {
+        return false;
     }
-    
-    // Add penalty for doubled pawns
-    const int doubledPawnPenalty = 30;
-    const int doubledPawnPenaltyDE = 40;
-    const int doubleIsolatedPenalty = 30;
 
-    for (int i = 0; i < 8; i++) {
-        if (i == 3 || i == 4) {
-            value -= (files[i] - 1) * doubledPawnPenaltyDE;
-        } else {
-            value -= (files[i] - 1) * doubledPawnPenalty;
+    std::uint64_t sqBit = 1ULL << sqIndex;
+    return (entry.pawnAttacks[color] & sqBit) && !(entry.attackSpans[!color] & sqBit);
+}
+
+/*------------------------------------------------------------------------
+Build the attack maps of both sides. Bishops see through their own queens 
+and rooks through their own rooks and queens, so batteries count for 
+mobility and king safety. Pieces threatening the enemy king are gathered 
+in the same pass: pawns near the king, pieces attacking a square next to 
+it, and queens, knights and bishops close to it.
+------------------------------------------------------------------------*/
+void computeAttacks(const Board& board, const PawnEntry& pawnEntry, AttackInfo& attacks) {
+    // Indexed by piece type, a negative distance means closeness does not count
+    const int threatDistance[6] = {4, 5, 4, -1, 6, -1};
+    const int threatWeight[6] = {15, 30, 30, 50, 100, 0};
+
+    Bitboard occupied = board.occ();
+
+    for (int c = 0; c < 2; c++) {
+        Color color = Color(c);
+        Square theirKingSq = board.kingSq(!color);
+        Bitboard kingZone = attacks::king(theirKingSq);
+
+        Bitboard queens = board.pieces(PieceType::QUEEN, color);
+        Bitboard rooks = board.pieces(PieceType::ROOK, color);
+        const Bitboard occupancy[6] = {occupied, occupied, occupied ^ queens, occupied ^ queens ^ rooks, occupied, occupied};
+
+        // Pawn and king attacks
+        Bitboard pawns = board.pieces(PieceType::PAWN, color);
+        std::uint64_t pushes = color == Color::WHITE ? pawns.getBits() << 8 : pawns.getBits() >> 8;
+        attacks.byType[c][0] = pawnEntry.pawnAttacks[c];
+        attacks.byType[c][5] = attacks::king(board.kingSq(color)).getBits();
+        attacks.all[c] = attacks.byType[c][0] | attacks.byType[c][5];
+        attacks.twice[c] = (eastOne(pushes) & westOne(pushes)) | (attacks.byType[c][0] & attacks.byType[c][5]);
+
+        int kingAttackers = 0;
+        int kingAttackWeight = 0;
+
+        while (pawns) {
+            int sqIndex = pawns.pop();
+            if (manhattanDistance(Square(sqIndex), theirKingSq) <= threatDistance[0]) {
+                kingAttackers++;
+                kingAttackWeight += threatWeight[0];
+            }
         }
 
-        if (i > 0 && i < 7 && files[i] > 1 && files[i - 1] == 0 && files[i + 1] == 0) {
-            value -= doubleIsolatedPenalty; // extra penalty for double & isolated pawns
-        } else if (files[i] > 1 && (files[i - 1] == 0 || files[i + 1] == 0)) {
-            value -= doubleIsolatedPenalty; // handling double isolated pawns at the edges
-        } 
-    }
+        // Knight, bishop, rook and queen attacks
+        for (int type = 1; type <= 4; type++) {
+            Bitboard pieces = board.pieces(PieceType(static_cast<PieceType::underlying>(type)), color);
+            attacks.byType[c][type] = 0;
+
+            while (pieces) {
+                int sqIndex = pieces.pop();
+                Square sq = Square(sqIndex);
+                std::uint64_t pieceAttacks;
+
+                switch (type) {
+                    case 1: pieceAttacks = attacks::knight(sq).getBits(); break;
+                    case 2: pieceAttacks = attacks::bishop(sq, occupancy[type]).getBits(); break;
+                    case 3: pieceAttacks = attacks::rook(sq, occupancy[type]).getBits(); break;
+                    default: pieceAttacks = attacks::queen(sq, occupancy[type]).getBits(); break;
+                }
 
-    #pragma omp critical
-    {
-        pawnHashTable[ourPawnsBits][theirPawnsBits] = value;
-    }
+                attacks.bySquare[sqIndex] = pieceAttacks;
+                attacks.byType[c][type] |= pieceAttacks;
+                attacks.twice[c] |= attacks.all[c] & pieceAttacks;
+                attacks.all[c] |= pieceAttacks;
 
-    return value;
+                bool beingClose = threatDistance[type] >= 0 && manhattanDistance(sq, theirKingSq) <= threatDistance[type];
+                if (beingClose || (kingZone & pieceAttacks)) {
+                    kingAttackers++;
+                    kingAttackWeight += threatWeight[type];
+                }
+            }
+        }
+
+        attacks.kingAttackers[c] = kingAttackers;
+        attacks.kingAttackWeight[c] = kingAttackWeight;
+    }
 }
 
 // Compute the value of the knights on the board
-int knightValue(const Board& board, int baseValue, Color color, Info& info) {
+Score knightValue(const Board& board, Color color, Info& info) {
 
     // Constants
     const int outpostBonus = 30;
-    double midGameWeight = info.gamePhase / 24.0;
-    double endGameWeight = 1.0 - midGameWeight;
 
     int knightAdjust[9] = {-20, -16, -12, -8, -4,  0,  4,  8, 12}; // Adjust the value of the knight based on the number of pawns
     const int mobilityBonus = 3;
@@ -990,147 +901,109 @@ int knightValue(const Board& board, int baseValue, Color color, Info& info) {
     int value = 0;
 
     while (!knights.empty()) {
-        value += baseValue + knightAdjust[ourPawnCount];
+        value += knightAdjust[ourPawnCount];
         int sqIndex = knights.lsb();
-        
-        if (color == Color::WHITE) {
-            value += static_cast<int>(midGameWeight * whiteKnightTableMid[sqIndex] + endGameWeight * whiteKnightTableEnd[sqIndex]);
-        } else {
-            value += static_cast<int>(midGameWeight * blackKnightTableMid[sqIndex] + endGameWeight * blackKnightTableEnd[sqIndex]);
-        }
 
-        if (isOutpost(board, sqIndex, color)) {
+        if (isOutpost(*info.pawnEntry, sqIndex, color)) {
             value += outpostBonus;
         }
 
         // Compute the mobility of the knight. 
         // We count the number of legal moves that don't land onto a pawn attack or blocked by our own pieces.
-        Bitboard knightMoves = attacks::knight(Square(sqIndex));
-        int mobility = 0;
-        while (!knightMoves.empty()) {
-            
-            int sqIndexMove = knightMoves.lsb();
-            Bitboard blocked = board.us(color) & Bitboard::fromSquare(sqIndexMove);
-            
-            if (!isProtectedByPawn(sqIndexMove, board, !color) && !blocked) {
-                mobility++;
-            }
-            knightMoves.clear(sqIndexMove);
-        }
+        Bitboard knightMoves = Bitboard(info.attacks.bySquare[sqIndex] & ~info.attacks.byType[!color][0]) & ~board.us(color);
+        int mobility = knightMoves.count();
         value +=  mobilityBonus * (mobility - 4);
 
         const int protectedBonus = 4;
-        if (isProtected(board, color, sqIndex)) {
+        if ((info.attacks.all[color] >> sqIndex) & 1) {
             value += protectedBonus;
         }
 
-
         knights.clear(sqIndex);
     }
 
-    return value;
+    return makeScore(value, value);
 }
 
 // Compute the value of the bishops on the board
-int bishopValue(const Board& board, int baseValue, Color color, Info& info) {
+Score bishopValue(const Board& board, Color color, Info& info) {
 
     // Constants
     const int outpostBonus = 30;
     const int protectionBonus = 3;
 
-    double midGameWeight = info.gamePhase / 24.0;
-    double endGameWeight = 1.0 - midGameWeight;
-
-    int bishopPairBonus = 30 * endGameWeight;
+    const Score bishopPairBonus = makeScore(0, 30);
     int rookAdjust[9] = {15, 12, 9, 6, 3, 0, -3, -6, -9};
     int mobilityBonus = 2;
 
     Bitboard bishops = board.pieces(PieceType::BISHOP, color);
     Bitboard ourPawns = board.pieces(PieceType::PAWN, color);
     int value = 0;
+    Score score = 0;
     
     if (bishops.count() >= 2) {
-        value += bishopPairBonus;
+        score += bishopPairBonus;
     }
  
     while (!bishops.empty()) {
-        value += baseValue;
         int sqIndex = bishops.lsb();
-        if (color == Color::WHITE) {
-            value += static_cast<int>(midGameWeight * whiteBishopTableMid[sqIndex] + endGameWeight * whiteBishopTableEnd[sqIndex]);
-        } else {
-            value += static_cast<int>(midGameWeight * blackBishopTableMid[sqIndex] + endGameWeight * blackBishopTableEnd[sqIndex]);
-        }
 
-        Bitboard bishopMoves = attacks::bishop(Square(sqIndex), ourPawns);
+        Bitboard bishopMoves = Bitboard(info.attacks.bySquare[sqIndex]);
 
         int mobility = std::min(bishopMoves.count(), 12);
         value += mobilityBonus * (mobility - 7);
 
-        if (isOutpost(board, sqIndex, color)) {
+        if (isOutpost(*info.pawnEntry, sqIndex, color)) {
             value += outpostBonus;
         }
 
         const int protectedBonus = 4;
-        if (isProtected(board, color, sqIndex)) {
+        if ((info.attacks.all[color] >> sqIndex) & 1) {
             value += protectedBonus;
         }
 
         bishops.clear(sqIndex);
     }
 
-    return value;
+    return score + makeScore(value, value);
 }
 
 
 // Compute the total value of the rooks on the board
-int rookValue(const Board& board, int baseValue, Color color, Info& info) {
+Score rookValue(const Board& board, Color color, Info& info) {
 
     // Constants
     const int semiOpenFileBonus = 10;
     const int openFileBonus = 15;
-    
-    
 
-    double midGameWeight = info.gamePhase / 24.0;
-    double endGameWeight = 1.0 - midGameWeight;
     int rookAdjust[9] = {15, 12, 9, 6, 3, 0, -3, -6, -9};
 
     // Give a bigger bonus for mobility near the endgame
-    int mobilityBonus = info.gamePhase < 12 ? 3 : 2;
+    const Score mobilityBonus = makeScore(2, 3);
 
     Bitboard rooks = board.pieces(PieceType::ROOK, color);
     Bitboard ourPawns = board.pieces(PieceType::PAWN, color);
     int ourPawnCount = ourPawns.count();
 
     int value = 0;
+    Score score = 0;
 
     while (!rooks.empty()) {
         int sqIndex = rooks.lsb(); 
         int file = sqIndex % 8; 
         int rank = sqIndex / 8;
 
-        value += baseValue + rookAdjust[ourPawnCount];
+        value += rookAdjust[ourPawnCount];
 
-        if (color == Color::WHITE) {
-            value += static_cast<int>(midGameWeight * whiteRookTableMid[sqIndex] + endGameWeight * whiteRookTableEnd[sqIndex]);
-        } else {
-            value += static_cast<int>(midGameWeight * blackRookTableMid[sqIndex] + endGameWeight * blackRookTableEnd[sqIndex]);
-        }
-
-        if (info.openFiles[file]) {
+        if ((info.openFiles >> file) & 1) {
             value += openFileBonus;
-        } else {
-            if (info.semiOpenFilesWhite[file] && color == Color::WHITE) {
-                value += semiOpenFileBonus;
-            } else if (info.semiOpenFilesBlack[file] && color == Color::BLACK) {
-                value += semiOpenFileBonus;
-            }
+        } else if ((info.semiOpenFiles[color] >> file) & 1) {
+            value += semiOpenFileBonus;
         }
         
-        Bitboard rookMoves = attacks::rook(Square(sqIndex), board.occ());
+        Bitboard rookMoves = Bitboard(info.attacks.bySquare[sqIndex]);
         int mobility = std::min(rookMoves.count(), 12);
-        value += mobilityBonus * (mobility - 7);
+        score += mobilityBonus * (mobility - 7);
 
         const int pawnBlockPenalty = 20;
 
@@ -1143,33 +1016,29 @@ int rookValue(const Board& board, int baseValue, Color color, Info& info) {
         }
         
         const int protectedBonus = 4;
-        if (isProtected(board, color, sqIndex)) {
+        if ((info.attacks.all[color] >> sqIndex) & 1) {
             value += protectedBonus;
         }
 
         rooks.clear(sqIndex);
     }
     
-    return value;
+    return score + makeScore(value, value);
 }
 
 
 // Compute the total value of the queens on the board
-int queenValue(const Board& board, int baseValue, Color color, Info& info) {
-
-    // Constants
-    const int* queenTable;    
-    double midGameWeight = info.gamePhase / 24.0;
-    double endGameWeight = 1.0 - midGameWeight;
+Score queenValue(const Board& board, Color color, Info& info) {
 
     // Give a bigger bonus for mobility near the endgame
-    int mobilityBonus = info.gamePhase < 12 ? 2 : 1;
+    const Score mobilityBonus = makeScore(1, 2);
     
     Bitboard queens = board.pieces(PieceType::QUEEN, color);
     Bitboard theirKing = board.pieces(PieceType::KING, !color);
 
     Square theirKingSQ = Square(theirKing.lsb()); // Get the square of the their king
     int value = 0;
+    Score score = 0;
 
     Bitboard theirRooks = board.pieces(PieceType::ROOK, !color);
     Bitboard theirBishops = board.pieces(PieceType::BISHOP, !color);
@@ -1178,200 +1047,48 @@ int queenValue(const Board& board, int baseValue, Color color, Info& info) {
         int sqIndex = queens.lsb(); 
 
         int queenRank = sqIndex / 8, queenFile = sqIndex % 8;
-        value += baseValue; 
-        if (color == Color::WHITE) {
-            value += static_cast<int>(midGameWeight * whiteQueenTableMid[sqIndex] + endGameWeight * whiteQueenTableEnd[sqIndex]);
-        } else {
-            value += static_cast<int>(midGameWeight * blackQueenTableMid[sqIndex] + endGameWeight * blackQueenTableEnd[sqIndex]);
-        }
 
-        Bitboard queenMoves = attacks::queen(Square(sqIndex), board.occ());
+        Bitboard queenMoves = Bitboard(info.attacks.bySquare[sqIndex]);
         int mobility = std::min(queenMoves.count(), 12);
-        value += mobilityBonus * (mobility - 14);
+        score += mobilityBonus * (mobility - 14);
 
         const int protectedBonus = 4;
-        if (isProtected(board, color, sqIndex)) {
+        if ((info.attacks.all[color] >> sqIndex) & 1) {
             value += protectedBonus;
         }
 
         queens.clear(sqIndex); 
     }
-    return value;
+    return score + makeScore(value, value);
 }
 
-int kingThreat(const Board& board, Color color) {
-
-    Bitboard king = board.pieces(PieceType::KING, color);
-    int sqIndex = king.lsb();
-    int kingRank = sqIndex / 8, kingFile = sqIndex % 8;
-    int threatScore = 0;
-
-    // Penalty for being attacked
-    Bitboard attackers;
-    int numAttackers = 0;
-
-    // Get the adjacent squares to the king
-    Bitboard adjSq;
-    for (const auto& adjSqIndex : adjSquares.at(sqIndex)) {
-        adjSq = adjSq | Bitboard::fromSquare(adjSqIndex);
-    }
-
-    // A pawn is a threat if it is within Manhattan distance of 4
-    Bitboard theirPawns = board.pieces(PieceType::PAWN, !color);
-    while (theirPawns) {
-        int pawnIndex = theirPawns.lsb();
-
-        if (manhattanDistance(Square(pawnIndex), Square(sqIndex)) <= 4) {
-            attackers.set(pawnIndex);
-        }
-
-        theirPawns.clear(pawnIndex);
-    }
-
-    theirPawns = board.pieces(PieceType::PAWN, !color);
-
-    /*--------------------------------------------------------------
-     Check for attacks from other pieces
-     A piece is a threat if it attacks the adjacent squares to the king 
-     given the presence of our pieces and their pawns
-    --------------------------------------------------------------*/
-
-    Bitboard theirQueens = board.pieces(PieceType::QUEEN, !color);
-    Bitboard ourDefenders = board.us(color);
-
-    while (theirQueens) {
-        // Count the queen as a threat if it is close or attacking an adjacent square
-        int queenIndex = theirQueens.lsb();
-
-        Bitboard queenAttacks = attacks::queen(Square(queenIndex), ourDefenders | theirPawns);
-
-        bool beingClose = (manhattanDistance(Square(queenIndex), Square(sqIndex)) <= 6);
-        bool attackingAdj = (queenAttacks & adjSq).count() > 0;
-
-        if (beingClose || attackingAdj) {
-            attackers.set(queenIndex);
-        }
-
-        theirQueens.clear(queenIndex);
-    }
-
-    Bitboard theirRooks = board.pieces(PieceType::ROOK, !color);
-    while (theirRooks) {
-        // Count the rook as a threat if it is attacking an adjacent square 
-        int rookIndex = theirRooks.lsb();
-        
-        Bitboard rookAttacks = attacks::rook(Square(rookIndex), ourDefenders | theirPawns);
-        bool attackingAdj = (rookAttacks & adjSq).count() > 0;
-
-        if (attackingAdj) {
-            attackers.set(rookIndex);
-        }
-
-        theirRooks.clear(rookIndex);
-    }
-
-    Bitboard theirKnight = board.pieces(PieceType::KNIGHT, !color);
-    while (theirKnight) {
-        // Count the knight as a threat if it is close 
-        int knightIndex = theirKnight.lsb();
-        Bitboard knightAttacks = attacks::knight(Square(knightIndex));
-
-        bool beingClose = (manhattanDistance(Square(knightIndex), Square(sqIndex)) <= 5);
-        bool attackingAdj = (knightAttacks & adjSq).count() > 0;
-
-        if (beingClose || attackingAdj) {
-            attackers.set(knightIndex);
-        }
-
-        theirKnight.clear(knightIndex);
-    }
-
-    Bitboard theirBishop = board.pieces(PieceType::BISHOP, !color);
-    while (theirBishop) {
-        // Count the bishop as a threat if it is close or attacking an adjacent square
-        int bishopIndex = theirBishop.lsb();
-        Bitboard bishopAttacks = attacks::bishop(Square(bishopIndex), ourDefenders | theirPawns);
-
-        bool beingClose = (manhattanDistance(Square(bishopIndex), Square(sqIndex)) <= 4);
-        bool attackingAdj = (bishopAttacks & adjSq).count() > 0;
-
-        if (beingClose || attackingAdj) {
-            attackers.set(bishopIndex);
-        }
-
-        theirBishop.clear(bishopIndex);
-    }
-
-    // Scale the adjacent square attacks by the number of attackers
-    numAttackers = attackers.count();
-
-    // The more attackers, the higher the penalty
-    int attackWeight = 0; 
-    switch (numAttackers) {
-        case 0: attackWeight = 0; break;
-        case 1: attackWeight = 25; break;  
-        case 2: attackWeight = 65; break;  
-        case 3: attackWeight = 100; break; 
-        case 4: attackWeight = 120; break; 
-        case 5: attackWeight = 150; break; 
-        case 6: attackWeight = 175; break; 
-        case 7: attackWeight = 200; break; 
-        case 8: attackWeight = 200; break; 
-        default: break;
-    }
-
-    while (attackers) {
-        int attackerIndex = attackers.lsb();
-        Piece attacker = board.at(Square(attackerIndex));
-
-        // Add scores as integers
-        if (attacker.type() == PieceType::PAWN) {
-            threatScore += attackWeight * 15; // Scaled integer math
-        } else if (attacker.type() == PieceType::KNIGHT) {
-            threatScore += attackWeight * 30;
-        } else if (attacker.type() == PieceType::BISHOP) {
-            threatScore += attackWeight * 30;
-        } else if (attacker.type() == PieceType::ROOK) {
-            threatScore += attackWeight * 50;
-        } else if (attacker.type() == PieceType::QUEEN) {
-            threatScore += attackWeight * 100;
-        }
-
-        attackers.clear(attackerIndex);
-    }
-
-    return threatScore / 100;
-
+// Threat to the king of the given color from the attackers gathered by computeAttacks. 
+// The more attackers, the higher the penalty, up to KING_THREAT_CAP.
+int kingThreat(const AttackInfo& attacks, Color color) {
+    const int attackWeights[9] = {0, 25, 65, 100, 120, 150, 175, 200, 200};
+    
+    int numAttackers = std::min(attacks.kingAttackers[!color], 8);
+    return std::min(attackWeights[numAttackers] * attacks.kingAttackWeight[!color] / 100, KING_THREAT_CAP);
 }
 
 /*------------------------------------------------------------------------
-Compute the value of the king on the board. This is an expensive function
-since it involves a lot of computation checking for threats to the king.
+Compute the value of the king on the board: threats from the attack maps,
+shelter by pawns and pieces, open files and king activity in the end game.
 ------------------------------------------------------------------------*/
-int kingValue(const Board& board, int baseValue, Color color, Info& info) {
-
-    double midGameWeight = info.gamePhase / 24.0;
-    double endGameWeight = 1.0 - midGameWeight;
+Score kingValue(const Board& board, Color color, Info& info) {
     
     Bitboard king = board.pieces(PieceType::KING, color);
     const PieceType allPieceTypes[] = {PieceType::KNIGHT, PieceType::BISHOP, PieceType::ROOK, PieceType::QUEEN};
     
-    int value = baseValue;
+    Score value = 0;
     int sqIndex = king.lsb();
     int kingRank = sqIndex / 8, kingFile = sqIndex % 8;
-    
-    if (color == Color::WHITE) {
-        value += static_cast<int>(midGameWeight * whiteKingTableMid[sqIndex] + endGameWeight * whiteKingTableEnd[sqIndex]);
-    } else {
-        value += static_cast<int>(midGameWeight * blackKingTableMid[sqIndex] + endGameWeight * blackKingTableEnd[sqIndex]);
-    }
 
-    int threatScore = kingThreat(board, color) * midGameWeight; // Scale the threat score by the game phase (heavy toward midgame)
-    int originalThreatScore =  kingThreat(board, color);
-    value -= threatScore;
+    // The threat score only counts in the middle game
+    value -= makeScore(kingThreat(info.attacks, color), 0);
 
-    // King protection by pawns, scale the bonus by the game phase (heavy toward midgame)
-    int pawnShieldBonus = 30 * midGameWeight;
+    // King protection by pawns, only in the middle game
+    const Score pawnShieldBonus = makeScore(30, 0);
     Bitboard ourPawns = board.pieces(PieceType::PAWN, color);
     Bitboard theirPawns = board.pieces(PieceType::PAWN, !color);
 
@@ -1390,8 +1107,8 @@ int kingValue(const Board& board, int baseValue, Color color, Info& info) {
         ourPawns.clear(pawnIndex);
     }
     
-    // King protection by pieces, scale the bonus by the game phase (heavy toward midgame)
-    int pieceProtectionBonus = 30 * midGameWeight;
+    // King protection by pieces, only in the middle game
+    const Score pieceProtectionBonus = makeScore(30, 0);
     for (const auto& type : allPieceTypes) {
         Bitboard pieces = board.pieces(type, color);
         
@@ -1410,37 +1127,25 @@ int kingValue(const Board& board, int baseValue, Color color, Info& info) {
         }
     }
 
-    // Penalty for being on or next to an open file (heavy toward midgame)
-    int numAdjOpenFiles = 0;
+    // Penalty for being on or next to an open file, only in the middle game
     const int openFilePenalty[4] = {0, 20, 35, 60};
 
-    if (info.openFiles[kingFile] || info.semiOpenFilesWhite[kingFile] || info.semiOpenFilesBlack[kingFile]) {
-        numAdjOpenFiles++;
-    }
-
-    if (kingFile > 0 && (info.openFiles[kingFile - 1] 
-        || info.semiOpenFilesWhite[kingFile - 1] 
-        || info.semiOpenFilesBlack[kingFile - 1])) {
-        numAdjOpenFiles++;
-    }
-
-    if (kingFile < 7 && (info.openFiles[kingFile + 1] 
-        || info.semiOpenFilesWhite[kingFile + 1] 
-        || info.semiOpenFilesBlack[kingFile + 1])) {
-        numAdjOpenFiles++;
-    }
+    std::uint8_t kingFiles = static_cast<std::uint8_t>((0x7 << kingFile) >> 1);
+    std::uint8_t openOrSemiOpen = info.openFiles | info.semiOpenFiles[0] | info.semiOpenFiles[1];
+    int numAdjOpenFiles = popCount(kingFiles & openOrSemiOpen);
 
-    value -= openFilePenalty[numAdjOpenFiles] * midGameWeight;
+    value -= makeScore(openFilePenalty[numAdjOpenFiles], 0);
 
-    int kingDistancePenalty = 6;
-    int pawnDistancePenalty = 3;
-    int passedPawnDistancePenalty = 6;
+    // Distance penalties only count in the end game
+    const Score kingDistancePenalty = makeScore(0, 6);
+    const Score pawnDistancePenalty = makeScore(0, 3);
+    const Score passedPawnDistancePenalty = makeScore(0, 6);
 
     Bitboard theirKing = board.pieces(PieceType::KING, !color);
     int theirKingIndex = theirKing.lsb();
 
     int dist = manhattanDistance(Square(sqIndex), Square(theirKingIndex)); 
-    value -= kingDistancePenalty * dist * endGameWeight; // Stronger penalty for being far away from the opponent king in the endgame
+    value -= kingDistancePenalty * dist; // Stronger penalty for being far away from the opponent king in the endgame
 
     ourPawns = board.pieces(PieceType::PAWN, color);
     theirPawns = board.pieces(PieceType::PAWN, !color);
@@ -1450,10 +1155,10 @@ int kingValue(const Board& board, int baseValue, Color color, Info& info) {
         int pawnSqIndex = ourPawns.lsb();
         dist = manhattanDistance(Square(sqIndex), Square(pawnSqIndex));
         
-        if (isPassedPawn(pawnSqIndex, color, theirPawns)) {
-            value -= passedPawnDistancePenalty * dist * endGameWeight;
+        if (info.pawnEntry->passedPawns[color] & (1ULL << pawnSqIndex)) {
+            value -= passedPawnDistancePenalty * dist;
         } else {
-            value -= pawnDistancePenalty * dist * endGameWeight;
+            value -= pawnDistancePenalty * dist;
         }
         
         ourPawns.clear(pawnSqIndex); 
@@ -1463,10 +1168,10 @@ int kingValue(const Board& board, int baseValue, Color color, Info& info) {
         int pawnSqIndex = theirPawns.lsb();
         dist = manhattanDistance(Square(sqIndex), Square(pawnSqIndex));
         
-        if (isPassedPawn(pawnSqIndex, !color, ourPawns)) {
-            value -= passedPawnDistancePenalty * dist * endGameWeight;
+        if (info.pawnEntry->passedPawns[!color] & (1ULL << pawnSqIndex)) {
+            value -= passedPawnDistancePenalty * dist;
         } else {
-            value -= pawnDistancePenalty * dist * endGameWeight;
+            value -= pawnDistancePenalty * dist;
         }
         
         theirPawns.clear(pawnSqIndex); 
@@ -1475,8 +1180,26 @@ int kingValue(const Board& board, int baseValue, Color color, Info& info) {
     return value;
 }
 
-// Function to evaluate the board position
+// Evaluate a board that is not an EvalBoard by building the piece-square sums first
 int evaluate(const Board& board) {
+    return evaluate(EvalBoard(board));
+}
+
+// Evaluate the board position with the full pipeline
+int evaluate(const EvalBoard& board) {
+    return evaluate(board, std::numeric_limits<int>::min(), std::numeric_limits<int>::max());
+}
+
+/*------------------------------------------------------------------------
+Evaluate the board position in stages. Material, piece-square tables and 
+the other cheap terms come first; if that estimate is more than the lazy 
+margin outside [alpha, beta], the positional terms (pawn structure, 
+mobility, king safety and patterns) are unlikely to bring it back in the 
+window and the estimate is returned as is. The margin is an empirical 
+bound, not a proven one, so in rare positions the estimate can land on 
+the wrong side of the window.
+------------------------------------------------------------------------*/
+int evaluate(const EvalBoard& board, int alpha, int beta) {
     // Constant
     const int tempoBonus = 10;
 
@@ -1484,42 +1207,46 @@ int evaluate(const Board& board) {
     int whiteScore = 0;
     int blackScore = 0;
 
-    if (knownDraw(board)) {
+    // Known draws and specialized endgames come from the material hash table
+    const MaterialEntry& material = probeMaterialTable(board);
+
+    if (material.draw) {
         return 0;
     }
-    
-    /*--------------------------------------------------------------------------
-    Mop-up phase: if only their king is left without any other pieces.
-    Aim to checkmate.
-    --------------------------------------------------------------------------*/
 
-    if (board.us(Color::WHITE).count() == 1 && board.us(Color::BLACK).count() == 1) {
-        return 0; 
+    if (material.endgame != nullptr) {
+        return material.endgame(board, material.strongSide);
     }
 
-    bool mopUp = board.us(Color::WHITE).count() == 1 || board.us(Color::BLACK).count() == 1;
+    // Positions evaluated before, e.g. in an earlier iteration, come from the evaluation cache
+    std::uint64_t key = board.hash();
+    EvalCacheEntry& cached = evalCacheSlot(key);
+    if (cached.key == key) {
+        return cached.eval;
+    }
 
-    Color winningColor = board.us(Color::WHITE).count() > 1 ? Color::WHITE : Color::BLACK;
+    /*--------------------------------------------------------------------------
+    Lazy evaluation phase
+    --------------------------------------------------------------------------*/
 
-    Bitboard pieces = board.pieces(PieceType::PAWN, winningColor) | board.pieces(PieceType::KNIGHT, winningColor) | 
-                    board.pieces(PieceType::BISHOP, winningColor) | board.pieces(PieceType::ROOK, winningColor) | 
-                    board.pieces(PieceType::QUEEN, winningColor);
+    // Material and piece-square tables, kept up to date by EvalBoard as moves are made.
+    // Terms that depend on the game phase are packed scores, tapered once at the end.
+    Score score = board.psqScore(Color::WHITE) - board.psqScore(Color::BLACK);
 
-    if (mopUp) {
-        Square winningKingSq = Square(board.pieces(PieceType::KING, winningColor).lsb());
-        Square losingKingSq = Square(board.pieces(PieceType::KING, !winningColor).lsb());
-        Square E4 = Square(28);
+    // Tempo bonus
+    if (board.sideToMove() == Color::WHITE) {
+        whiteScore += tempoBonus;
+    } else {
+        blackScore += tempoBonus;
+    }
 
-        int kingDist = manhattanDistance(winningKingSq, losingKingSq);
-        int distToCenter = manhattanDistance(losingKingSq, E4);
-        int winningMaterial = 900 * board.pieces(PieceType::QUEEN, winningColor).count() + 
-                          500 * board.pieces(PieceType::ROOK, winningColor).count() + 
-                          300 * board.pieces(PieceType::BISHOP, winningColor).count() + 
-                          300 * board.pieces(PieceType::KNIGHT, winningColor).count() + 
-                          100 * board.pieces(PieceType::PAWN, winningColor).count(); // avoid throwing away pieces
-        int score = 5000 +  500 * distToCenter + 150 * (14 - kingDist);
+    // Piece and material deficit penalties
+    whiteScore -= material.deficitPenalty[0];
+    blackScore -= material.deficitPenalty[1];
 
-        return winningColor == Color::WHITE ? score : -score;
+    int lazyEval = taper(score, material.gamePhase) + whiteScore - blackScore;
+    if (lazyEval - LAZY_EVAL_MARGIN >= beta || lazyEval + LAZY_EVAL_MARGIN <= alpha) {
+        return lazyEval;
     }
 
     /*--------------------------------------------------------------------------
@@ -1528,15 +1255,9 @@ int evaluate(const Board& board) {
     Info info;
 
     // Early queen development penalty
-    Bitboard whiteKnights = board.pieces(PieceType::KNIGHT, Color::WHITE);
-    Bitboard blackKnights = board.pieces(PieceType::KNIGHT, Color::BLACK);
-
     Bitboard whiteBishops = board.pieces(PieceType::BISHOP, Color::WHITE);
     Bitboard blackBishops = board.pieces(PieceType::BISHOP, Color::BLACK);
 
-    Bitboard whiteRooks = board.pieces(PieceType::ROOK, Color::WHITE);
-    Bitboard blackRooks = board.pieces(PieceType::ROOK, Color::BLACK);
-
     Bitboard whiteQueen = board.pieces(PieceType::QUEEN, Color::WHITE);
     Bitboard blackQueen = board.pieces(PieceType::QUEEN, Color::BLACK);
 
@@ -1546,117 +1267,26 @@ int evaluate(const Board& board) {
     Bitboard whiteKing = board.pieces(PieceType::KING, Color::WHITE);
     Bitboard blackKing = board.pieces(PieceType::KING, Color::BLACK);
 
-    // Tempo bonus
-    if (board.sideToMove() == Color::WHITE) {
-        whiteScore += tempoBonus;
-    } else {
-        blackScore += tempoBonus;
-    }
+    info.gamePhase = material.gamePhase;
 
-    info.gamePhase = gamePhase(board);
-    if (info.gamePhase > 24) {
-        info.gamePhase = 24;
-    }
-
-    // Compute open files and semi-open files
-    for (int i = 0; i < 8; i++) {
-        info.openFiles[i] = isOpenFile(board, i);
-        if (!info.openFiles[i]) {
-            info.semiOpenFilesWhite[i] = isSemiOpenFile(board, i, Color::WHITE);
-            info.semiOpenFilesBlack[i] = isSemiOpenFile(board, i, Color::BLACK);
-        }
-    }
+    // Pawn structure and open files and semi-open files from the pawn hash table
+    const PawnEntry& pawnEntry = probePawnTable(board);
+    info.pawnEntry = &pawnEntry;
 
-    // Traverse each piece type
-    const PieceType allPieceTypes[] = {PieceType::PAWN, PieceType::KNIGHT, PieceType::BISHOP, 
-                                           PieceType::ROOK, PieceType::QUEEN, PieceType::KING};
+    info.openFiles = ~(pawnEntry.pawnFiles[0] | pawnEntry.pawnFiles[1]);
+    info.semiOpenFiles[0] = ~pawnEntry.pawnFiles[0] & pawnEntry.pawnFiles[1];
+    info.semiOpenFiles[1] = ~pawnEntry.pawnFiles[1] & pawnEntry.pawnFiles[0];
 
+    // Attack maps shared by the piece functions
+    computeAttacks(board, pawnEntry, info.attacks);
 
-    for (const auto& type : allPieceTypes) {
-        // Determine base value of the current piece type
-        int baseValue = 0;
-
-        switch (type.internal()) {
-            case PieceType::PAWN: baseValue = PAWN_VALUE; break;
-            case PieceType::KNIGHT: baseValue = KNIGHT_VALUE; break;
-            case PieceType::BISHOP: baseValue = BISHOP_VALUE; break;
-            case PieceType::ROOK: baseValue = ROOK_VALUE; break;
-            case PieceType::QUEEN: baseValue = QUEEN_VALUE; break;
-            case PieceType::KING: baseValue = KING_VALUE; break;
-            default: break;
-        }
-
-        if (type == PieceType::KNIGHT) {
-            whiteScore += knightValue(board, baseValue, Color::WHITE, info);
-            blackScore += knightValue(board, baseValue, Color::BLACK, info);
-            if (whiteScore < 0) {
-                std::cout << "K issue" << std::endl;
-            }
-        } else if (type == PieceType::BISHOP) {
-            whiteScore += bishopValue(board, baseValue, Color::WHITE, info);
-            blackScore += bishopValue(board, baseValue, Color::BLACK, info);
-            if (whiteScore < 0) {
-                std::cout << "B issue" << std::endl;
-            }
-        } else if (type == PieceType::KING) {
-            whiteScore += kingValue(board, baseValue, Color::WHITE, info);
-            blackScore += kingValue(board, baseValue, Color::BLACK, info);
-            if (whiteScore < 0) {
-                std::cout << "K issue" << std::endl;
-            }
-        }  else if (type == PieceType::PAWN) {
-            whiteScore += pawnValue(board, baseValue, Color::WHITE, info);
-            blackScore += pawnValue(board, baseValue, Color::BLACK, info);
-            if (whiteScore < 0) {
-                std::cout << "P issue" << std::endl;
-            }
-        } else if (type == PieceType::ROOK) {
-            whiteScore += rookValue(board, baseValue, Color::WHITE, info);
-            blackScore += rookValue(board, baseValue, Color::BLACK, info);
-            if (whiteScore < 0) {
-                std::cout << "R issue" << std::endl;
-            }
-        } else if (type == PieceType::QUEEN) {
-            whiteScore += queenValue(board, baseValue, Color::WHITE, info);
-            blackScore += queenValue(board, baseValue, Color::BLACK, info);
-            if (whiteScore < 0) {
-                std::cout << "Q issue" << std::endl; }
-        } 
-    }
-    
-    /*-------------------------------------------------------------------------
-        Add a penalty for piece-material deficit. At the beginning, the deficit is 24 * 2 = 48.
-        As the game progresses, the penalty decreases. 
-        This is useful to avoid trading pieces for pawns early on.
-    -------------------------------------------------------------------------*/
-    const int knightValue = 3, bishopValue = 3, rookValue = 5, queenValue = 9, pawnValue = 1;
-
-    int whitePieceValue = queenValue * whiteQueen.count() + rookValue * whiteRooks.count() + 
-                        bishopValue * whiteBishops.count() + knightValue * whiteKnights.count();
-
-    int blackPieceValue = queenValue * blackQueen.count() + rookValue * blackRooks.count() + 
-                        bishopValue * blackBishops.count() + knightValue * blackKnights.count();
-    
-    int pieceDeficitPenalty = info.gamePhase * 5;
-    
-    if (whitePieceValue < blackPieceValue) {
-        whiteScore -= pieceDeficitPenalty;
-    } else if (blackPieceValue < whitePieceValue) {
-        blackScore -= pieceDeficitPenalty;
-    }
-
-    /*--------------------------------------------------------------------------
-        Add a penalty for material deficit to make sure the position advantage is real.
-    --------------------------------------------------------------------------*/
-    const int deficitPenalty = 50;
-    int whiteMaterial = whitePieceValue + pawnValue * whitePawns.count();
-    int blackMaterial = blackPieceValue + pawnValue * blackPawns.count();
-
-    if (whiteMaterial < blackMaterial) {
-        whiteScore -= deficitPenalty;
-    } else if (blackMaterial < whiteMaterial) {
-        blackScore -= deficitPenalty;
-    }
+    // Positional terms of each piece type
+    score += pawnValue(Color::WHITE, info) - pawnValue(Color::BLACK, info);
+    score += knightValue(board, Color::WHITE, info) - knightValue(board, Color::BLACK, info);
+    score += bishopValue(board, Color::WHITE, info) - bishopValue(board, Color::BLACK, info);
+    score += rookValue(board, Color::WHITE, info) - rookValue(board, Color::BLACK, info);
+    score += queenValue(board, Color::WHITE, info) - queenValue(board, Color::BLACK, info);
+    score += kingValue(board, Color::WHITE, info) - kingValue(board, Color::BLACK, info);
 
     /*--------------------------------------------------------------------------
         Pattern detection
@@ -1802,5 +1432,9 @@ int evaluate(const Board& board) {
         blackScore -= blockedFianchettoPenalty;
     }
 
-    return whiteScore - blackScore;
+    int eval = taper(score, info.gamePhase) + whiteScore - blackScore;
+    cached.key = key;
+    cached.eval = eval;
+
+    return eval;
 }
\ No newline at end of file
@@ -1,29 +1,129 @@
 #pragma once
 
+#include <cstdint>
 #include "chess.hpp"
 
 using namespace chess;
 
+/**
+ * Middle and end game values packed into one 32-bit integer, the end game value in the upper
+ * half. Scores add, subtract and scale by integers like plain ints and are tapered by the game
+ * phase once, at the end of evaluate.
+ */
+typedef std::int32_t Score;
+
+constexpr Score makeScore(int mg, int eg)
+{
+    return static_cast<Score>(static_cast<std::uint32_t>(eg) << 16) + mg;
+}
+
+inline int mgValue(Score score)
+{
+    return static_cast<std::int16_t>(static_cast<std::uint16_t>(static_cast<std::uint32_t>(score)));
+}
+
+inline int egValue(Score score)
+{
+    return static_cast<std::int16_t>(static_cast<std::uint16_t>(static_cast<std::uint32_t>(score + 0x8000) >> 16));
+}
+
+/**
+ * Interpolate a score between its middle game (phase 24) and end game (phase 0) values.
+ */
+inline int taper(Score score, int phase)
+{
+    return (mgValue(score) * phase + egValue(score) * (24 - phase)) / 24;
+}
+
+/**
+ * Pawn structure data of one pawn configuration, cached in the pawn hash table.
+ * Arrays are indexed by color.
+ */
+struct PawnEntry
+{
+    std::uint64_t key;
+    Score score[2];               // Pawn structure score, without base values
+    std::uint64_t passedPawns[2]; // Passed pawns
+    std::uint64_t pawnAttacks[2]; // Squares attacked by pawns
+    std::uint64_t attackSpans[2]; // Squares pawns can attack as they advance
+    std::uint8_t pawnFiles[2];    // Files with at least one pawn, one bit per file
+};
+
+/**
+ * Evaluation of a specialized endgame from white's point of view, given the stronger side.
+ */
+typedef int (*EndgameFunction)(const Board &board, Color strongSide);
+
+/**
+ * Material data of one material configuration, cached in the material hash table.
+ * Arrays are indexed by color.
+ */
+struct MaterialEntry
+{
+    std::uint64_t key;
+    int gamePhase;              // Game phase 0-24
+    int imbalance;              // Material imbalance in centipawns, white minus black
+    int deficitPenalty[2];      // Penalties for being behind in pieces or material
+    bool draw;                  // Known draw by insufficient material
+    EndgameFunction endgame;    // Specialized endgame evaluation, nullptr if none
+    Color strongSide;           // Side the endgame evaluation is for
+};
+
+/**
+ * Attack maps of both sides, computed once per evaluate by computeAttacks.
+ * Arrays are indexed by color, then by piece type.
+ */
+struct AttackInfo
+{
+    std::uint64_t byType[2][6];  // Squares attacked by each piece type
+    std::uint64_t all[2];        // Squares attacked by any piece
+    std::uint64_t twice[2];      // Squares attacked at least twice
+    std::uint64_t bySquare[64];  // Attacks of the knight, bishop, rook or queen on a square
+    int kingAttackers[2];        // Number of pieces threatening the enemy king
+    int kingAttackWeight[2];     // Summed threat weight of those pieces
+};
+
+/**
+ * Per-call evaluation data shared by the piece functions. Trivially constructible, every
+ * field is filled in by evaluate before use. File masks have one bit per file.
+ */
 struct Info
 {
-    std::vector<bool> openFiles;          // 8 elements, each for a file's openness (true or false)
-    std::vector<bool> semiOpenFilesWhite; // 8 elements for white's semi-open files
-    std::vector<bool> semiOpenFilesBlack; // 8 elements for black's semi-open files
+    std::uint8_t openFiles;        // Files without pawns
+    std::uint8_t semiOpenFiles[2]; // Files with only enemy pawns, indexed by color
     int gamePhase;
+    const PawnEntry* pawnEntry;    // Pawn hash table entry of the position
+    AttackInfo attacks;            // Attack maps of the position
+};
+
+/**
+ * Board that keeps the material and piece-square score of each side.
+ * The sums are updated as makeMove and unmakeMove place and remove pieces, so evaluate does not
+ * loop over the pieces for them. The search works on an EvalBoard.
+ */
+class EvalBoard : public Board
+{
+public:
+    explicit EvalBoard(std::string_view fen = constants::STARTPOS) : Board(fen) { refreshScores(); }
+    explicit EvalBoard(const Board &board) : Board(board) { refreshScores(); }
 
-    // Constructor to initialize the vectors with 8 elements, all set to false
-    Info()
-        : openFiles(8, false),
-          semiOpenFilesWhite(8, false),
-          semiOpenFilesBlack(8, false)
+    void setFen(std::string_view fen) override
     {
+        Board::setFen(fen);
+        refreshScores();
     }
-};
 
-extern std::unordered_map<std::uint64_t, std::unordered_map<std::uint64_t, int>> whitePawnHashTable;
-extern std::unordered_map<std::uint64_t, std::unordered_map<std::uint64_t, int>> blackPawnHashTable;
+    Score psqScore(Color color) const { return psqScore_[color]; }
+
+protected:
+    void placePiece(Piece piece, Square sq) override;
+    void removePiece(Piece piece, Square sq) override;
 
-extern const std::unordered_map<int, std::vector<int>> adjSquares;
+private:
+    void refreshScores();
+
+    Score psqScore_[2] = {0, 0};
+};
 
 /*------------------------------------------------------------------------
     Helper Functions
@@ -40,11 +140,10 @@ int materialImbalance(const Board& board);
 int gamePhase(const Board &board);
 
 /**
- * Generate a bitboard mask for the specified file.
- * @param file The file for which to generate the mask.
- * @return The bitboard mask for the specified file.
+ * Look up the material configuration of the board in the material hash table.
+ * @return The entry, valid until the next probe from the same thread.
  */
-Bitboard generateFileMask(int file);
+const MaterialEntry& probeMaterialTable(const Board &board);
 
 /**
  * Returns whether the game is in an endgame state.
@@ -76,89 +175,78 @@ int minDistance(const Square &sq1, const Square &sq2);
  */
 int manhattanDistance(const Square &sq1, const Square &sq2);
 
-/*
- * Check if the given square is an outpost for the given color.
- * @param board The chess board.
- * @param sqIndex The index of the square to check.
- * @param color The color of the outpost.
- * @return True if the square is an outpost, otherwise false.
- */
-bool isOutpost(const Board &board, int sqIndex, Color color);
-
-/*
- *   Open file check
- */
-bool isOpenFile(const chess::Board &board, int file);
-
-/*
- *   Semi-open file check from the perspective of the given color
- */
-bool isSemiOpenFile(const chess::Board &board, int file, Color color);
-
 /*------------------------------------------------------------------------
     Main Functions
 ------------------------------------------------------------------------*/
 
 /**
- * Clear the pawn hash table.
+ * Clear the pawn hash tables of all threads.
  */
 void clearPawnHashTable();
 
 /**
- * Compute the value of pawns on the board.
- * @param board The chess board.
- * @param baseValue The base value of a pawn.
+ * Compute the positional value of pawns on the board. Like the other piece functions
+ * below, base values and piece-square tables are left out since EvalBoard keeps them.
  * @param color The color of pawns to evaluate.
- * @return The total value of pawns for the specified color.
+ * @return The positional value of pawns for the specified color.
  */
-int pawnValue(const Board &board, int baseValue, Color color, Info &info);
+Score pawnValue(Color color, Info &info);
 
 /**
- * Compute the value of knights on the board.
+ * Compute the positional value of knights on the board.
  * @param board The chess board.
- * @param baseValue The base value of a knight.
  * @param color The color of knights to evaluate.
- * @return The total value of knights for the specified color.
+ * @return The positional value of knights for the specified color.
  */
-int knightValue(const Board &board, int baseValue, Color color, Info &info);
+Score knightValue(const Board &board, Color color, Info &info);
 
 /**
- * Compute the value of bishops on the board.
+ * Compute the positional value of bishops on the board.
  * @param board The chess board.
- * @param baseValue The base value of a bishop.
  * @param color The color of bishops to evaluate.
- * @return The total value of bishops for the specified color.
+ * @return The positional value of bishops for the specified color.
  */
-int bishopValue(const Board &board, int baseValue, Color color, Info &info);
+Score bishopValue(const Board &board, Color color, Info &info);
 
 /**
- * Compute the value of rooks on the board.
+ * Compute the positional value of rooks on the board.
  * @param board The chess board.
- * @param baseValue The base value of a rook.
  * @param color The color of rooks to evaluate.
- * @return The total value of rooks for the specified color.
+ * @return The positional value of rooks for the specified color.
  */
-int rookValue(const Board &board, int baseValue, Color color, Info &info);
+Score rookValue(const Board &board, Color color, Info &info);
 
 /**
- * Compute the value of queens on the board.
+ * Compute the positional value of queens on the board.
  * @param board The chess board.
- * @param baseValue The base value of a queen.
  * @param color The color of queens to evaluate.
- * @return The total value of queens for the specified color.
+ * @return The positional value of queens for the specified color.
+ */
+Score queenValue(const Board &board, Color color, Info &info);
+
+/**
+ * Compute the threat to the king of the given color.
+ * @param attacks The attack maps of the position.
+ * @param color The color of the king.
+ * @return The threat score, higher is more dangerous.
  */
-int queenValue(const Board &board, int baseValue, Color color, Info &info);
+int kingThreat(const AttackInfo &attacks, Color color);
 
-int kingThreat(const Board &board, Color color);
+/**
+ * Compute the attack maps of both sides and gather the pieces threatening each king.
+ * @param board The chess board.
+ * @param pawnEntry The pawn hash table entry of the position.
+ * @param attacks The attack maps to fill.
+ */
+void computeAttacks(const Board &board, const PawnEntry &pawnEntry, AttackInfo &attacks);
 
 /**
- * Compute the value of kings on the board.
+ * Compute the positional value of kings on the board.
  * @param board The chess board.
- * @param baseValue The base value of a king.
  * @param color The color of kings to evaluate.
- * @return The total value of kings for the specified color.
+ * @return The positional value of kings for the specified color.
  */
-int kingValue(const Board &board, int baseValue, Color color, Info &info);
+Score kingValue(const Board &board, Color color, Info &info);
 
 /**
  * Compute the reward for center control.
@@ -170,4 +258,19 @@ int centerControl(const Board &board, Color color);
  * @param board The chess board.
  * @return The evaluation score of the position (positive if white is better, negative if black is better).
  */
+int evaluate(const EvalBoard &board);
+
+/**
+ * Evaluate the board position, returning a cheap estimate when it is far outside [alpha, beta].
+ * @param board The chess board.
+ * @param alpha The lower bound of the window, from white's point of view.
+ * @param beta The upper bound of the window, from white's point of view.
+ * @return The evaluation score of the position from white's point of view. Outside the window
+ * it may be the estimate from material and piece-square tables only.
+ */
+int evaluate(const EvalBoard &board, int alpha, int beta);
+
+/**
+ * Evaluate a plain board. Slower, the piece-square sums are computed from scratch.
+ */
 int evaluate(const Board &board);
@@ -11,6 +11,16 @@
 #include <stdlib.h>
 #include <cmath>
 #include <unordered_set>
+#include <atomic>
+#include <cstring>
+#include <cstdlib>
+#include <memory>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#elif defined(_WIN32)
+#include <malloc.h>
+#endif
 
 using namespace chess;
 
@@ -21,32 +31,22 @@ typedef std::uint64_t U64;
     Constants and global variables.
 --------------------------------------------------------------------------------------------*/
 
-std::unordered_map<U64, std::pair<int, int>> transpositionTable; // Hash -> (eval, depth)
-std::unordered_map<U64, Move> hashMoveTable; // Hash -> move
-
 std::chrono::time_point<std::chrono::high_resolution_clock> hardDeadline; // Search hardDeadline
 std::chrono::time_point<std::chrono::high_resolution_clock> softDeadline;
 
-const int maxTableSize = 10000000; // Maximum size of the transposition table
-U64 nodeCount; // Node count for each thread
-U64 tableHit;
-std::vector<Move> previousPV; // Principal variation from the previous iteration
-std::vector<std::vector<Move>> killerMoves(1000); // Killer moves
-
-int globalMaxDepth = 0; // Maximum depth of current search
-bool mopUp = false; // Mop up flag
+std::atomic<bool> stopSearch(false); // Set when the main thread finishes to stop the helper threads
 
 const int ENGINE_DEPTH = 30; // Maximum search depth for the current engine version
 
-// Basic piece values for move ordering, detection of sacrafices, etc.
+// Basic piece values for move ordering, detection of sacrafices, etc. Indexed by PieceType.
 const int pieceValues[] = {
-    0,    // No piece
-    100,  // Pawn
-    320,  // Knight
-    330,  // Bishop
-    500,  // Rook
-    900,  // Queen
-    20000 // King
+    100,   // Pawn
+    320,   // Knight
+    330,   // Bishop
+    500,   // Rook
+    900,   // Queen
+    20000, // King
+    0      // No piece
 };
 
 const int checkExtension = 1; // Number of plies to extend for checks
@@ -55,35 +55,323 @@ const int promotionExtension = 1; // Number of plies to extend for promotion thr
 const int oneReplyExtension = 1; // Number of plies to extend if there is only one legal move.
 const int captureExtension = 1; // Number of plies to extend for recaptures
 
+const int MAX_PLY = 128; // Deepest ply covered by the search stack
+const int EVAL_NONE = -32768; // No static evaluation, e.g. when in check
+const int MAX_HISTORY = 16384; // History scores stay within [-MAX_HISTORY, MAX_HISTORY]
+
 
 /*-------------------------------------------------------------------------------------------- 
-    Transposition table lookup.
+    Per-ply search data. Each node fills in its own entry before searching its children, so 
+    a node can look at what its ancestors saw.
 --------------------------------------------------------------------------------------------*/
-bool tableLookUp(U64 hash, int depth, int& eval) {    
-    auto it = transpositionTable.find(hash);
-    bool found = it != transpositionTable.end() && it->second.second >= depth;
+struct StackEntry {
+    int staticEval = EVAL_NONE; // Static evaluation from the side to move's point of view
+    Move move = Move(Move::NO_MOVE); // Move being searched from this ply, NULL_MOVE for a null move
+    Piece movedPiece; // Piece making that move
+};
 
-    if (found) {
-        eval = it->second.first;
-        return true;
-    } else {
-        return false;
+// History of quiet moves indexed by the moving piece and its destination square
+typedef std::int16_t PieceToHistory[12][64];
+
+
+/*-------------------------------------------------------------------------------------------- 
+    Search state owned by a single thread. Nothing in here is shared, so the search never 
+    locks to update it. Counters are atomics only so that the main thread can sum them while 
+    the helpers are running; each is written by its owner thread alone.
+--------------------------------------------------------------------------------------------*/
+struct alignas(64) SearchThread {
+    int id = 0;
+    std::atomic<U64> nodes{0}; // Nodes searched in the current search
+    std::atomic<U64> tableHits{0}; // Transposition table cutoffs in the current search
+    int maxDepth = 0; // Depth of the current iteration
+    bool mopUp = false; // Mop up flag
+    std::vector<Move> previousPV; // Principal variation from the previous iteration
+    StackEntry stack[MAX_PLY]; // Search stack indexed by ply
+    Move killers[MAX_PLY][2] = {}; // Quiet moves that caused a beta cutoff at each ply, newest first
+
+    // Quiet move ordering. Kept between searches and halved at the start of each one.
+    std::int16_t history[2][64][64] = {}; // Butterfly history by side to move, from and to square
+    Move counterMoves[12][64] = {}; // Quiet move that refuted the previous move, by its piece and to square
+    PieceToHistory continuationHistory[12][64] = {}; // History following the previous piece and to square
+};
+
+std::vector<std::unique_ptr<SearchThread>> threadPool; // One per search thread, kept between searches
+
+/*-------------------------------------------------------------------------------------------- 
+    Count a node for this thread.
+--------------------------------------------------------------------------------------------*/
+inline void countNode(SearchThread& thread) {
+    thread.nodes.store(thread.nodes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+/*-------------------------------------------------------------------------------------------- 
+    Total nodes searched by all threads in the current search.
+--------------------------------------------------------------------------------------------*/
+U64 totalNodes() {
+    U64 total = 0;
+    for (const auto& thread : threadPool) {
+        total += thread->nodes.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+/*-------------------------------------------------------------------------------------------- 
+    Transposition table.
+    A preallocated power-of-two array of 64-byte buckets, four entries per bucket, so a probe 
+    touches a single cache line. Each entry is two 64-bit words: the key XOR'ed with the data 
+    and the data itself. A write torn by another thread fails the XOR check on the next probe 
+    and is treated as a miss, so threads share the table without any locking.
+
+    Entries are never flushed during a game. Each search bumps a 5-bit generation counter and
+    stores it as the entry age, and replacement prefers slots that are shallow or were written
+    by older searches, so stale knowledge is overwritten gradually instead of all at once.
+
+    Data layout (bits):
+    0-17  score (signed)
+    18-24 depth
+    25-26 bound
+    27-31 age
+    32-47 best move
+    48-63 static evaluation (signed, EVAL_NONE if unknown)
+--------------------------------------------------------------------------------------------*/
+enum Bound : std::uint8_t {
+    BOUND_NONE = 0,
+    BOUND_UPPER = 1, // Fail low, the true score is at most the stored score
+    BOUND_LOWER = 2, // Fail high, the true score is at least the stored score
+    BOUND_EXACT = 3
+};
+
+struct TableEntry {
+    int eval;
+    int depth;
+    Bound bound;
+    Move move;
+    int staticEval;
+};
+
+struct TTSlot {
+    std::atomic<U64> key; // hash ^ data
+    std::atomic<U64> data;
+};
+
+struct alignas(64) TTBucket {
+    TTSlot slots[4];
+};
+
+TTBucket* transpositionTable = nullptr;
+size_t tableBuckets = 0; // Number of buckets, always a power of two
+std::uint8_t tableGeneration = 0; // Current search generation, stored as the entry age
+
+inline U64 packEntry(int eval, int depth, Bound bound, int age, Move move, int staticEval) {
+    return (static_cast<U64>(eval) & 0x3FFFF)
+        | (static_cast<U64>(std::clamp(depth, 0, 127)) << 18)
+        | (static_cast<U64>(bound) << 25)
+        | (static_cast<U64>(age & 0x1F) << 27)
+        | (static_cast<U64>(move.move()) << 32)
+        | (static_cast<U64>(static_cast<std::uint16_t>(std::clamp(staticEval, EVAL_NONE, 32767))) << 48);
+}
+
+inline TableEntry unpackEntry(U64 data) {
+    TableEntry entry;
+    entry.eval = static_cast<int>(static_cast<std::int32_t>(static_cast<std::uint32_t>(data << 14)) >> 14); // sign-extend 18 bits
+    entry.depth = static_cast<int>((data >> 18) & 0x7F);
+    entry.bound = static_cast<Bound>((data >> 25) & 0x3);
+    entry.move = Move(static_cast<std::uint16_t>(data >> 32));
+    entry.staticEval = static_cast<std::int16_t>(static_cast<std::uint16_t>(data >> 48));
+    return entry;
+}
+
+// Number of generations since the entry was written, modulo the 5-bit age field
+inline int entryAge(U64 data) {
+    return (tableGeneration - static_cast<int>((data >> 27) & 0x1F)) & 0x1F;
+}
+
+inline TTBucket& tableBucket(U64 hash) {
+    // The table size is a power of two so the low bits of the hash select the bucket
+    return transpositionTable[hash & (tableBuckets - 1)];
+}
+
+/*-------------------------------------------------------------------------------------------- 
+    Allocate memory for the transposition table. On Linux the block is aligned to 2MB and
+    marked for transparent huge pages, which cuts TLB misses on a table of this size.
+--------------------------------------------------------------------------------------------*/
+void* allocateTable(size_t bytes) {
+#if defined(__linux__)
+    const size_t alignment = 2 * 1024 * 1024;
+    size_t size = ((bytes + alignment - 1) / alignment) * alignment;
+    void* mem = std::aligned_alloc(alignment, size);
+    if (mem) {
+        madvise(mem, size, MADV_HUGEPAGE);
+    }
+    return mem;
+#elif defined(_WIN32)
+    return _aligned_malloc(bytes, 64);
+#else
+    return std::aligned_alloc(64, ((bytes + 63) / 64) * 64);
+#endif
+}
+
+void freeTable(void* mem) {
+#if defined(_WIN32)
+    _aligned_free(mem);
+#else
+    std::free(mem);
+#endif
+}
+
+/*-------------------------------------------------------------------------------------------- 
+    Transposition table lookup. Returns true and fills entry if the position is stored.
+--------------------------------------------------------------------------------------------*/
+bool tableLookUp(U64 hash, TableEntry& entry) {
+    TTBucket& bucket = tableBucket(hash);
+
+    for (auto& slot : bucket.slots) {
+        U64 data = slot.data.load(std::memory_order_relaxed);
+        U64 key = slot.key.load(std::memory_order_relaxed);
+
+        if ((key ^ data) == hash && data != 0) {
+            entry = unpackEntry(data);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*-------------------------------------------------------------------------------------------- 
+    Whether a stored entry decides the node for the window [alpha, beta]. An exact score always 
+    does, a lower bound does if it fails high, and an upper bound does if it fails low.
+--------------------------------------------------------------------------------------------*/
+inline bool tableCutoff(const TableEntry& entry, int alpha, int beta) {
+    return entry.bound == BOUND_EXACT
+        || (entry.bound == BOUND_LOWER && entry.eval >= beta)
+        || (entry.bound == BOUND_UPPER && entry.eval <= alpha);
+}
+
+/*-------------------------------------------------------------------------------------------- 
+    Transposition table store. An entry for the same position is only overwritten by a result 
+    that is exact, comparably deep, or from a newer search. Otherwise the victim is an empty 
+    slot if there is one, else the slot with the lowest depth, where every generation of age 
+    counts as 8 plies of depth lost.
+--------------------------------------------------------------------------------------------*/
+void tableStore(U64 hash, int eval, int depth, Bound bound, Move move, int staticEval = EVAL_NONE) {
+    TTBucket& bucket = tableBucket(hash);
+    TTSlot* replace = &bucket.slots[0];
+    int replaceWorth = INF;
+
+    for (auto& slot : bucket.slots) {
+        U64 data = slot.data.load(std::memory_order_relaxed);
+        U64 key = slot.key.load(std::memory_order_relaxed);
+
+        if (data == 0) {
+            replace = &slot;
+            break;
+        }
+
+        if ((key ^ data) == hash) {
+            TableEntry old = unpackEntry(data);
+
+            if (bound != BOUND_EXACT && depth + 3 < old.depth && entryAge(data) == 0) {
+                return;
+            }
+
+            // Keep the old best move and static evaluation if we don't have new ones for this position
+            if (move == Move::NO_MOVE) {
+                move = old.move;
+            }
+            if (staticEval == EVAL_NONE) {
+                staticEval = old.staticEval;
+            }
+            replace = &slot;
+            break;
+        }
+
+        int worth = unpackEntry(data).depth - 8 * entryAge(data);
+        if (worth < replaceWorth) {
+            replaceWorth = worth;
+            replace = &slot;
+        }
     }
+
+    U64 data = packEntry(eval, depth, bound, tableGeneration, move, staticEval);
+    replace->key.store(hash ^ data, std::memory_order_relaxed);
+    replace->data.store(data, std::memory_order_relaxed);
 }
 
+/*-------------------------------------------------------------------------------------------- 
+    Clear all search tables. Called when a new game starts.
+--------------------------------------------------------------------------------------------*/
 void clearTables() {
-    if (transpositionTable.size() > maxTableSize) {
-        transpositionTable = {};
-        hashMoveTable = {};
-        clearPawnHashTable();
+    if (transpositionTable == nullptr) {
+        resizeTables(DEFAULT_HASH_MB);
+    }
+
+    std::memset(static_cast<void*>(transpositionTable), 0, tableBuckets * sizeof(TTBucket));
+    clearPawnHashTable();
+
+    // Move ordering history belongs to the previous game
+    for (auto& thread : threadPool) {
+        std::memset(thread->history, 0, sizeof(thread->history));
+        std::memset(static_cast<void*>(thread->counterMoves), 0, sizeof(thread->counterMoves));
+        std::memset(thread->continuationHistory, 0, sizeof(thread->continuationHistory));
+    }
+}
+
+/*-------------------------------------------------------------------------------------------- 
+    Reallocate the transposition table to the largest power-of-two number of buckets that 
+    fits in the given number of megabytes. If the memory is not available the previous table 
+    is kept as it is, or without one the default size is used.
+--------------------------------------------------------------------------------------------*/
+void resizeTables(int megabytes) {
+    size_t bytes = static_cast<size_t>(std::max(megabytes, 1)) * 1024 * 1024;
+    size_t buckets = 1;
+    while (buckets * 2 * sizeof(TTBucket) <= bytes) {
+        buckets *= 2;
     }
+
+    TTBucket* table = static_cast<TTBucket*>(allocateTable(buckets * sizeof(TTBucket)));
+
+    if (table == nullptr) {
+        if (transpositionTable != nullptr) {
+            std::cout << "info string Failed to allocate " << megabytes << " MB for the hash table, keeping "
+                      << tableBuckets * sizeof(TTBucket) / (1024 * 1024) << " MB" << std::endl;
+            return;
+        }
+        if (megabytes > DEFAULT_HASH_MB) {
+            std::cout << "info string Failed to allocate " << megabytes << " MB for the hash table, using "
+                      << DEFAULT_HASH_MB << " MB" << std::endl;
+            resizeTables(DEFAULT_HASH_MB);
+            return;
+        }
+        std::cout << "info string Failed to allocate the hash table" << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+
+    if (transpositionTable != nullptr) {
+        freeTable(transpositionTable);
+    }
+
+    transpositionTable = table;
+    tableBuckets = buckets;
+
+    clearTables();
 }
  
 /*-------------------------------------------------------------------------------------------- 
-    Check if the move is a queen promotion.
+    Whether the current search must stop, either because the hard deadline has passed or 
+    because the main thread has finished.
+--------------------------------------------------------------------------------------------*/
+inline bool searchStopped() {
+    return stopSearch.load(std::memory_order_relaxed) 
+        || std::chrono::high_resolution_clock::now() >= hardDeadline;
+}
+
+/*-------------------------------------------------------------------------------------------- 
+    Check if the move is a promotion. The move type is compared exactly since the castling 
+    flag shares its bits with the promotion flag.
 --------------------------------------------------------------------------------------------*/
 bool isPromotion(const Move& move) {
-    if (move.typeOf() & Move::PROMOTION) {
+    if (move.typeOf() == Move::PROMOTION) {
         return true;
     } 
     return false;
@@ -92,14 +380,118 @@ bool isPromotion(const Move& move) {
 /*-------------------------------------------------------------------------------------------- 
     Update the killer moves.
 --------------------------------------------------------------------------------------------*/
-void updateKillerMoves(const Move& move, int depth) {
-    #pragma omp critical
-    {
-        if (killerMoves[depth].size() < 2) {
-            killerMoves[depth].push_back(move);
-        } else {
-            killerMoves[depth][1] = killerMoves[depth][0];
-            killerMoves[depth][0] = move;
+void updateKillerMoves(SearchThread& thread, const Move& move, int ply) {
+    Move* killers = thread.killers[ply];
+    if (killers[0] != move) {
+        killers[1] = killers[0];
+        killers[0] = move;
+    }
+}
+
+bool isKillerMove(const SearchThread& thread, const Move& move, int ply) {
+    return thread.killers[ply][0] == move || thread.killers[ply][1] == move;
+}
+
+/*-------------------------------------------------------------------------------------------- 
+    Continuation history for the move made at the given ply, or nullptr if there is none 
+    (before the first ply or after a null move).
+--------------------------------------------------------------------------------------------*/
+PieceToHistory* continuationTable(SearchThread& thread, int ply) {
+    if (ply < 0) {
+        return nullptr;
+    }
+
+    const StackEntry& entry = thread.stack[ply];
+    if (entry.move == Move::NO_MOVE || entry.move == Move::NULL_MOVE) {
+        return nullptr;
+    }
+    return &thread.continuationHistory[entry.movedPiece][entry.move.to().index()];
+}
+
+/*-------------------------------------------------------------------------------------------- 
+    Ordering score of a quiet move at the given ply: butterfly history plus the continuation 
+    histories following our previous move and the opponent's last move.
+--------------------------------------------------------------------------------------------*/
+int quietScore(SearchThread& thread, const Board& board, Move move, int ply) {
+    Piece piece = board.at(move.from());
+    int to = move.to().index();
+    int score = thread.history[static_cast<int>(board.sideToMove())][move.from().index()][to];
+
+    for (int back = 1; back <= 2; back++) {
+        PieceToHistory* table = continuationTable(thread, ply - back);
+        if (table != nullptr) {
+            score += (*table)[piece][to];
+        }
+    }
+    return score;
+}
+
+/*-------------------------------------------------------------------------------------------- 
+    Gravity update: the entry moves towards the bonus and shrinks as it approaches the limit, 
+    so moves that stop working lose their score quickly.
+--------------------------------------------------------------------------------------------*/
+void updateHistoryEntry(std::int16_t& entry, int bonus) {
+    entry += bonus - entry * std::abs(bonus) / MAX_HISTORY;
+}
+
+void updateQuietHistory(SearchThread& thread, const Board& board, Move move, int ply, int bonus) {
+    Piece piece = board.at(move.from());
+    int to = move.to().index();
+    updateHistoryEntry(thread.history[static_cast<int>(board.sideToMove())][move.from().index()][to], bonus);
+
+    for (int back = 1; back <= 2; back++) {
+        PieceToHistory* table = continuationTable(thread, ply - back);
+        if (table != nullptr) {
+            updateHistoryEntry((*table)[piece][to], bonus);
+        }
+    }
+}
+
+/*-------------------------------------------------------------------------------------------- 
+    Reward a quiet move that caused a beta cutoff and penalize the quiet moves searched before 
+    it. The move also becomes the counter move to the opponent's last move.
+--------------------------------------------------------------------------------------------*/
+void updateQuietHistories(SearchThread& thread, 
+                          const Board& board, 
+                          Move move, 
+                          int ply, 
+                          int depth, 
+                          const Move* quietsSearched, 
+                          int numQuiets) {
+
+    int bonus = std::min(32 * depth * depth, 1200);
+    updateQuietHistory(thread, board, move, ply, bonus);
+    for (int i = 0; i < numQuiets; i++) {
+        updateQuietHistory(thread, board, quietsSearched[i], ply, -bonus);
+    }
+
+    if (ply > 0) {
+        const StackEntry& previous = thread.stack[ply - 1];
+        if (previous.move != Move::NO_MOVE && previous.move != Move::NULL_MOVE) {
+            thread.counterMoves[previous.movedPiece][previous.move.to().index()] = move;
+        }
+    }
+}
+
+/*-------------------------------------------------------------------------------------------- 
+    Age the quiet move history at the start of a search.
+--------------------------------------------------------------------------------------------*/
+void ageHistory(SearchThread& thread) {
+    for (auto& side : thread.history) {
+        for (auto& from : side) {
+            for (auto& entry : from) {
+                entry /= 2;
+            }
+        }
+    }
+
+    for (auto& piece : thread.continuationHistory) {
+        for (auto& table : piece) {
+            for (auto& row : table) {
+                for (auto& entry : row) {
+                    entry /= 2;
+                }
+            }
         }
     }
 }
@@ -161,55 +553,201 @@ bool promotionThreatMove(Board& board, Move move) {
     return false;
 }
 
-/**
- * SEE (Static Exchange Evaluation) function.
- */
-int see(Board& board, Move move) {
-    int to = move.to().index();
-    
-    // Get victim and attacker piece values
-    auto victim = board.at<Piece>(move.to());
-    auto attacker = board.at<Piece>(move.from());
-    
-    int victimValue = pieceValues[static_cast<int>(victim.type())];
-    int attackerValue = pieceValues[static_cast<int>(attacker.type())];
+/*-------------------------------------------------------------------------------------------- 
+    Static exchange evaluation helpers. All pieces of both colors attacking a square given an 
+    occupancy, and the least valuable piece of a set of attackers.
+--------------------------------------------------------------------------------------------*/
+Bitboard attackersTo(const Board& board, Square square, Bitboard occupied) {
+    Bitboard bishopsQueens = board.pieces(PieceType::BISHOP) | board.pieces(PieceType::QUEEN);
+    Bitboard rooksQueens = board.pieces(PieceType::ROOK) | board.pieces(PieceType::QUEEN);
+
+    Bitboard attackers = (attacks::pawn(Color::BLACK, square) & board.pieces(PieceType::PAWN, Color::WHITE))
+                       | (attacks::pawn(Color::WHITE, square) & board.pieces(PieceType::PAWN, Color::BLACK))
+                       | (attacks::knight(square) & board.pieces(PieceType::KNIGHT))
+                       | (attacks::bishop(square, occupied) & bishopsQueens)
+                       | (attacks::rook(square, occupied) & rooksQueens)
+                       | (attacks::king(square) & board.pieces(PieceType::KING));
+    return attackers & occupied;
+}
+
+PieceType leastValuableAttacker(const Board& board, Bitboard attackers, Bitboard& attackerBit) {
+    for (int type = 0; type <= static_cast<int>(PieceType::underlying::KING); type++) {
+        Bitboard subset = attackers & board.pieces(static_cast<PieceType::underlying>(type));
+        if (subset) {
+            attackerBit = Bitboard::fromSquare(subset.lsb());
+            return static_cast<PieceType::underlying>(type);
+        }
+    }
+    return PieceType::NONE;
+}
+
+// Pieces moving off the line to the target square may uncover sliders behind them
+Bitboard xrayAttackers(const Board& board, Square square, Bitboard occupied, PieceType moved) {
+    Bitboard attackers = 0ULL;
+    if (moved == PieceType::PAWN || moved == PieceType::BISHOP || moved == PieceType::QUEEN) {
+        attackers |= attacks::bishop(square, occupied) 
+                   & (board.pieces(PieceType::BISHOP) | board.pieces(PieceType::QUEEN));
+    }
+    if (moved == PieceType::ROOK || moved == PieceType::QUEEN) {
+        attackers |= attacks::rook(square, occupied) 
+                   & (board.pieces(PieceType::ROOK) | board.pieces(PieceType::QUEEN));
+    }
+    return attackers & occupied;
+}
+
+/*-------------------------------------------------------------------------------------------- 
+    Static exchange evaluation. Returns true if the material balance of the capture sequence on 
+    the target square of a move, with both sides recapturing with their least valuable piece 
+    and free to stop, is at least threshold. Works on bitboards only, so the board is never 
+    modified, and stops as soon as the outcome relative to the threshold is known.
+--------------------------------------------------------------------------------------------*/
+bool seeGe(const Board& board, Move move, int threshold) {
+    if (move.typeOf() == Move::CASTLING) {
+        return threshold <= 0;
+    }
 
-    // Material gain from the first capture
-    int materialGain = victimValue - attackerValue;
+    Square to = move.to();
+    Bitboard occupied = board.occ() ^ Bitboard::fromSquare(move.from());
+    PieceType mover = board.at<PieceType>(move.from());
+    int captured = pieceValues[static_cast<int>(board.at<PieceType>(to))];
+
+    if (move.typeOf() == Move::ENPASSANT) {
+        captured = pieceValues[static_cast<int>(PieceType::PAWN)];
+        occupied ^= Bitboard::fromSquare(to.ep_square());
+    } else if (move.typeOf() == Move::PROMOTION) {
+        mover = move.promotionType();
+        captured += pieceValues[static_cast<int>(mover)] - pieceValues[static_cast<int>(PieceType::PAWN)];
+    }
 
+    // Balance after the move if the opponent doesn't recapture
+    int swap = captured - threshold;
+    if (swap < 0) {
+        return false;
+    }
 
-    board.makeMove(move);
+    // Balance if the opponent recaptures and we stop
+    swap = pieceValues[static_cast<int>(mover)] - swap;
+    if (swap <= 0) {
+        return true;
+    }
 
-    Movelist subsequentCaptures;
-    movegen::legalmoves<movegen::MoveGenType::CAPTURE>(subsequentCaptures, board);
+    Bitboard attackers = attackersTo(board, to, occupied);
+    Color side = board.sideToMove();
+    bool result = true;
 
-    int maxSubsequentGain = 0;
-    
-    // Store attackers sorted by increasing value (weakest first)
-    std::vector<Move> attackers;
-    for (int i = 0; i < subsequentCaptures.size(); i++) {
-        if (subsequentCaptures[i].to() == to) {
-            attackers.push_back(subsequentCaptures[i]);
+    while (true) {
+        side = ~side;
+        attackers &= occupied;
+
+        Bitboard attackerBit;
+        PieceType attacker = leastValuableAttacker(board, attackers & board.us(side), attackerBit);
+        if (attacker == PieceType::NONE) {
+            break;
         }
-    }
 
-    // Sort attackers by piece value (weakest attacker moves first)
-    std::sort(attackers.begin(), attackers.end(), [&](const Move& a, const Move& b) {
-        return pieceValues[static_cast<int>(board.at<Piece>(a.from()).type())] < 
-               pieceValues[static_cast<int>(board.at<Piece>(b.from()).type())];
-    });
+        result = !result;
 
-    // Recursively evaluate each attacker
-    for (const Move& nextCapture : attackers) {
-        maxSubsequentGain = -std::max(maxSubsequentGain, see(board, nextCapture));
+        // Capturing with the king is only possible if the other side has no attackers left
+        if (attacker == PieceType::KING) {
+            return (attackers & board.us(~side)) ? !result : result;
+        }
+
+        swap = pieceValues[static_cast<int>(attacker)] - swap;
+        if (swap < static_cast<int>(result)) {
+            break;
+        }
+
+        occupied ^= attackerBit;
+        attackers |= xrayAttackers(board, to, occupied, attacker);
     }
 
-    // Undo the move before returning
-    board.unmakeMove(move);
-    
-    return materialGain + maxSubsequentGain;
+    return result;
+}
+
+/*-------------------------------------------------------------------------------------------- 
+    Squares from which the side to move would give check, computed once per node so that 
+    checking moves can be recognized without making them.
+--------------------------------------------------------------------------------------------*/
+struct CheckInfo {
+    Square theirKing;
+    Bitboard checkSquares[6]; // Squares from which each piece type attacks their king
+    Bitboard blockers; // Our pieces that may uncover an attack on their king when they move
+};
+
+CheckInfo computeCheckInfo(const Board& board) {
+    CheckInfo info;
+    Color us = board.sideToMove();
+    Bitboard occupied = board.occ();
+    Square king = board.kingSq(~us);
+
+    info.theirKing = king;
+    info.checkSquares[static_cast<int>(PieceType::PAWN)] = attacks::pawn(~us, king);
+    info.checkSquares[static_cast<int>(PieceType::KNIGHT)] = attacks::knight(king);
+    info.checkSquares[static_cast<int>(PieceType::BISHOP)] = attacks::bishop(king, occupied);
+    info.checkSquares[static_cast<int>(PieceType::ROOK)] = attacks::rook(king, occupied);
+    info.checkSquares[static_cast<int>(PieceType::QUEEN)] = info.checkSquares[static_cast<int>(PieceType::BISHOP)] 
+                                                          | info.checkSquares[static_cast<int>(PieceType::ROOK)];
+    info.checkSquares[static_cast<int>(PieceType::KING)] = 0ULL;
+
+    // Our pieces seen from their king, if one of our sliders stands right behind them on the line
+    Bitboard bishopsQueens = board.pieces(PieceType::BISHOP, us) | board.pieces(PieceType::QUEEN, us);
+    Bitboard rooksQueens = board.pieces(PieceType::ROOK, us) | board.pieces(PieceType::QUEEN, us);
+    Bitboard diagonal = info.checkSquares[static_cast<int>(PieceType::BISHOP)] & board.us(us);
+    Bitboard straight = info.checkSquares[static_cast<int>(PieceType::ROOK)] & board.us(us);
+
+    info.blockers = 0ULL;
+    if (attacks::bishop(king, occupied ^ diagonal) & bishopsQueens & ~diagonal) {
+        info.blockers |= diagonal;
+    }
+    if (attacks::rook(king, occupied ^ straight) & rooksQueens & ~straight) {
+        info.blockers |= straight;
+    }
+    return info;
 }
 
+/*-------------------------------------------------------------------------------------------- 
+    Returns true if a legal move gives check. Direct checks are read from the check squares, 
+    discovered checks are only looked for when a blocker moves. Castling and en passant are 
+    rare enough that they are simply made and unmade.
+--------------------------------------------------------------------------------------------*/
+bool givesCheck(Board& board, const CheckInfo& info, Move move) {
+    if (move.typeOf() == Move::CASTLING || move.typeOf() == Move::ENPASSANT) {
+        board.makeMove(move);
+        bool isCheck = board.inCheck();
+        board.unmakeMove(move);
+        return isCheck;
+    }
+
+    Color us = board.sideToMove();
+    Bitboard from = Bitboard::fromSquare(move.from());
+    Bitboard to = Bitboard::fromSquare(move.to());
+    Bitboard occupied = (board.occ() ^ from) | to;
+
+    if (move.typeOf() == Move::PROMOTION) {
+        Bitboard promotionAttacks = 0ULL;
+        switch (static_cast<int>(move.promotionType())) {
+            case static_cast<int>(PieceType::KNIGHT): promotionAttacks = attacks::knight(move.to()); break;
+            case static_cast<int>(PieceType::BISHOP): promotionAttacks = attacks::bishop(move.to(), occupied); break;
+            case static_cast<int>(PieceType::ROOK): promotionAttacks = attacks::rook(move.to(), occupied); break;
+            default: promotionAttacks = attacks::queen(move.to(), occupied); break;
+        }
+        if (promotionAttacks & Bitboard::fromSquare(info.theirKing)) {
+            return true;
+        }
+    } else if (info.checkSquares[static_cast<int>(board.at<PieceType>(move.from()))] & to) {
+        return true;
+    }
+
+    if (!(info.blockers & from)) {
+        return false;
+    }
+
+    // The moving piece no longer counts as a slider on its old square
+    Bitboard bishopsQueens = (board.pieces(PieceType::BISHOP, us) | board.pieces(PieceType::QUEEN, us)) & ~from;
+    Bitboard rooksQueens = (board.pieces(PieceType::ROOK, us) | board.pieces(PieceType::QUEEN, us)) & ~from;
+    return static_cast<bool>((attacks::bishop(info.theirKing, occupied) & bishopsQueens) 
+                           | (attacks::rook(info.theirKing, occupied) & rooksQueens));
+}
 
 /*--------------------------------------------------------------------------------------------
     Late move reduction. No reduction for the first few moves, checks, or when in check.
@@ -217,29 +755,33 @@ int see(Board& board, Move move) {
     isPV is true if the node is a principal variation node. However, right now it's not used 
     since our move ordering is not that good.
 --------------------------------------------------------------------------------------------*/
-int lateMoveReduction(Board& board, Move move, int i, int depth, int ply, bool isPV) {
+int lateMoveReduction(SearchThread& thread, 
+                      Board& board, 
+                      Move move, 
+                      bool isCheck, 
+                      int i, 
+                      int depth, 
+                      int ply, 
+                      bool isPV, 
+                      bool improving) {
 
     Color color = board.sideToMove();
-    board.makeMove(move);
-    bool isCheck = board.inCheck(); 
-    board.unmakeMove(move);
-
     bool isCapture = board.isCapture(move);
     bool inCheck = board.inCheck();
     bool isPromoting;
     bool isMateThreat = mateThreatMove(board, move);
     bool isPromotionThreat = promotionThreatMove(board, move);
-    bool isKillerMove = std::find(killerMoves[depth].begin(), killerMoves[depth].end(), move) != killerMoves[depth].end();
+    bool isKiller = isKillerMove(thread, move, ply);
 
-    bool noReduceCondition = mopUp || isMateThreat || isPromoting  || isPromotionThreat;
-    bool reduceLessCondition =  isCapture || isCheck || isKillerMove || inCheck;
+    bool noReduceCondition = thread.mopUp || isMateThreat || isPromoting  || isPromotionThreat;
+    bool reduceLessCondition =  isCapture || isCheck || isKiller || inCheck;
 
     int k1 = 5;
     int k2 = 8;
 
     if (i <= k1 || depth <= 2 || noReduceCondition) { 
         return depth - 1;
-    } else if (i <= k2 || reduceLessCondition || isKillerMove) {
+    } else if (i <= k2 || reduceLessCondition || isKiller || improving) {
         return depth - 2;
     } else {
         return depth - 3;
@@ -247,92 +789,282 @@ int lateMoveReduction(Board& board, Move move, int i, int depth, int ply, bool i
 }
 
 /*-------------------------------------------------------------------------------------------- 
-    Returns a list of candidate moves ordered by priority.
+    Check that a move taken from the transposition table, the previous PV or the killer moves 
+    is legal in this position. Only the moves of pieces of the same type as the one on the from 
+    square are generated.
 --------------------------------------------------------------------------------------------*/
-std::vector<std::pair<Move, int>> orderedMoves(
-    Board& board, 
-    int depth, std::vector<Move>& previousPV, 
-    bool leftMost) {
+bool isLegalMove(const Board& board, Move move) {
+    if (move == Move::NO_MOVE || move == Move::NULL_MOVE) {
+        return false;
+    }
+
+    Piece piece = board.at(move.from());
+    if (piece == Piece::NONE || piece.color() != board.sideToMove()) {
+        return false;
+    }
 
     Movelist moves;
-    movegen::legalmoves(moves, board);
+    movegen::legalmoves(moves, board, 1 << static_cast<int>(piece.type()));
+    return std::find(moves.begin(), moves.end(), move) != moves.end();
+}
 
-    std::vector<std::pair<Move, int>> candidates;
-    std::vector<std::pair<Move, int>> quietCandidates;
+/*-------------------------------------------------------------------------------------------- 
+    Staged move picker. Moves are generated lazily, in the order they are likely to cause a 
+    cutoff, so a node that cuts off early never generates or scores the rest of its moves.
+    1. The previous PV move and the hash move, checked for legality without generating moves
+    2. Captures and promotions, most valuable victim first
+    3. Killer moves and the counter move to the opponent's last move
+    4. Quiet moves, checks first and then by history
+    In check, the caller passes the evasions it has already generated and, after the PV and 
+    hash moves, they are returned in a single stage: captures, killers, then quiets by history.
+--------------------------------------------------------------------------------------------*/
+class MovePicker {
+public:
+    // killers points to the two killer moves of this ply, or is nullptr if there are none. 
+    // evasions is the list of legal moves when in check, nullptr otherwise.
+    MovePicker(SearchThread& searchThread, 
+               Board& position, 
+               const CheckInfo& positionCheckInfo, 
+               int currentPly, 
+               Move previousPvMove, 
+               Move tableMove, 
+               const Move* killers,
+               const Movelist* evasions = nullptr)
+        : thread(searchThread), 
+          board(position), 
+          checkInfo(positionCheckInfo), 
+          ply(currentPly), 
+          pvMove(previousPvMove), 
+          hashMove(tableMove) {
+        for (int i = 0; killers != nullptr && i < 2; i++) {
+            if (killers[i] != Move::NO_MOVE) {
+                killerMoves[numKillers++] = killers[i];
+            }
+        }
 
-    candidates.reserve(moves.size());
-    quietCandidates.reserve(moves.size());
+        if (ply > 0) {
+            const StackEntry& previous = thread.stack[ply - 1];
+            if (previous.move != Move::NO_MOVE && previous.move != Move::NULL_MOVE) {
+                counterMove = thread.counterMoves[previous.movedPiece][previous.move.to().index()];
+            }
+        }
 
-    bool whiteTurn = board.sideToMove() == Color::WHITE;
-    Color color = board.sideToMove();
-    U64 hash = board.hash();
+        if (evasions != nullptr) {
+            inCheck = true;
+            scoreEvasions(*evasions);
+        }
+    }
 
-    // Move ordering 1. promotion 2. captures 3. killer moves 4. hash 5. checks 6. quiet moves
-    for (const auto& move : moves) {
-        int priority = 0;
-        bool quiet = false;
-        int moveIndex = move.from().index() * 64 + move.to().index();
-        int ply = globalMaxDepth - depth;
-        bool hashMove = false;
-
-        // Previous PV move > hash moves > captures/killer moves > checks > quiet moves
-        if (hashMoveTable.count(hash) && hashMoveTable[hash] == move) {
-            priority = 9000;
-            candidates.push_back({move, priority});
-            hashMove = true;
-        }
-      
-        if (hashMove) continue;
-        
-        if (previousPV.size() > ply && leftMost) {
-            if (previousPV[ply] == move) {
-                priority = 10000; // PV move
+    // Return the next move, or Move::NO_MOVE once all moves have been returned
+    Move next() {
+        while (true) {
+            switch (stage) {
+                case PV_MOVE:
+                    stage = HASH_MOVE;
+                    if (isLegal(pvMove)) {
+                        return pvMove;
+                    }
+                    break;
+
+                case HASH_MOVE:
+                    stage = inCheck ? EVASIONS : GENERATE_CAPTURES;
+                    if (hashMove != pvMove && isLegal(hashMove)) {
+                        return hashMove;
+                    }
+                    break;
+
+                case EVASIONS:
+                    while (index < moves.size()) {
+                        Move move = pickBest();
+                        if (!isSearched(move)) {
+                            return move;
+                        }
+                    }
+                    stage = DONE;
+                    break;
+
+                case GENERATE_CAPTURES:
+                    generateCaptures();
+                    stage = CAPTURES;
+                    break;
+
+                case CAPTURES:
+                    while (index < moves.size()) {
+                        Move move = pickBest();
+                        if (!isSearched(move)) {
+                            return move;
+                        }
+                    }
+                    stage = KILLERS;
+                    break;
+
+                case KILLERS:
+                    while (killerIndex < numKillers) {
+                        Move move = killerMoves[killerIndex++];
+                        if (!isSearched(move) && !board.isCapture(move) && !isPromotion(move) 
+                            && isLegalMove(board, move)) {
+                            return move;
+                        }
+                    }
+                    stage = COUNTER_MOVE;
+                    break;
+
+                case COUNTER_MOVE:
+                    stage = GENERATE_QUIETS;
+                    if (!isSearched(counterMove) && !isKiller(counterMove) && !board.isCapture(counterMove) 
+                        && !isPromotion(counterMove) && isLegalMove(board, counterMove)) {
+                        return counterMove;
+                    }
+                    break;
+
+                case GENERATE_QUIETS:
+                    generateQuiets();
+                    stage = QUIETS;
+                    break;
+
+                case QUIETS:
+                    while (index < moves.size()) {
+                        Move move = pickBest();
+                        // Promotions were returned with the captures
+                        if (!isSearched(move) && !isKiller(move) && move != counterMove && !isPromotion(move)) {
+                            return move;
+                        }
+                    }
+                    stage = DONE;
+                    break;
+
+                case DONE:
+                    return Move::NO_MOVE;
             }
-        } else if (std::find(killerMoves[depth].begin(), killerMoves[depth].end(), move) != killerMoves[depth].end()) {
-            priority = 2000; // Killer moves
-        } else if (isPromotion(move)) {
-            priority = 6000; 
-        } else if (board.isCapture(move)) { 
-            priority = 4000 + see(board, move);
-        } else {
-            board.makeMove(move);
-            bool isCheck = board.inCheck();
-            board.unmakeMove(move);
+        }
+    }
 
-            if (isCheck) {
-                priority = 4000;
+private:
+    enum Stage { PV_MOVE, HASH_MOVE, GENERATE_CAPTURES, CAPTURES, KILLERS, COUNTER_MOVE, GENERATE_QUIETS, QUIETS, EVASIONS, DONE };
+
+    int capturedValue(Move move) const {
+        return move.typeOf() == Move::ENPASSANT ? pieceValues[static_cast<int>(PieceType::PAWN)]
+                                                : pieceValues[static_cast<int>(board.at<PieceType>(move.to()))];
+    }
+
+    int moverValue(Move move) const {
+        return pieceValues[static_cast<int>(board.at<PieceType>(move.from()))];
+    }
+
+    // Captures and capture promotions, plus quiet promotions from the pawns, scored by the value 
+    // of the captured piece and then by the value of the capturing piece (MVV-LVA)
+    void generateCaptures() {
+        moves.clear();
+        movegen::legalmoves<movegen::MoveGenType::CAPTURE>(moves, board);
+        for (int i = 0; i < moves.size(); i++) {
+            scores[i] = isPromotion(moves[i]) ? 6000 : 8 * capturedValue(moves[i]) - moverValue(moves[i]) / 100;
+        }
+
+        Movelist pawnMoves;
+        movegen::legalmoves<movegen::MoveGenType::QUIET>(pawnMoves, board, PieceGenType::PAWN);
+        for (const auto& move : pawnMoves) {
+            if (isPromotion(move)) {
+                scores[moves.size()] = move.promotionType() == PieceType::QUEEN ? 6000 : -6000;
+                moves.add(move);
+            }
+        }
+        index = 0;
+    }
+
+    // Quiet moves, the ones that give check first, then by history
+    void generateQuiets() {
+        moves.clear();
+        movegen::legalmoves<movegen::MoveGenType::QUIET>(moves, board);
+        for (int i = 0; i < moves.size(); i++) {
+            bool isCheck = givesCheck(board, checkInfo, moves[i]);
+            scores[i] = quietScore(thread, board, moves[i], ply) + (isCheck ? 4 * MAX_HISTORY : 0);
+        }
+        index = 0;
+    }
+
+    // Evasions in one list: captures and promotions by MVV-LVA, then killers, then quiets by history
+    void scoreEvasions(const Movelist& evasions) {
+        moves = evasions;
+        for (int i = 0; i < moves.size(); i++) {
+            Move move = moves[i];
+            if (isPromotion(move)) {
+                scores[i] = (1 << 20) + 6000;
+            } else if (board.isCapture(move)) {
+                scores[i] = (1 << 20) + 8 * capturedValue(move) - moverValue(move) / 100;
+            } else if (isKiller(move)) {
+                scores[i] = 1 << 19;
             } else {
-                quiet = true;
-                priority = 0;// quietPriority(board, move);
+                scores[i] = quietScore(thread, board, move, ply);
             }
-        } 
+        }
+        index = 0;
+    }
 
-        if (!quiet) {
-            candidates.push_back({move, priority});
-        } else {
-            quietCandidates.push_back({move, priority});
+    // In check the evasion list is complete, so a move is legal if it is in it
+    bool isLegal(Move move) const {
+        if (!inCheck) {
+            return isLegalMove(board, move);
         }
+        return move != Move::NO_MOVE && std::find(moves.begin(), moves.end(), move) != moves.end();
     }
 
-    // Sort capture, promotion, checks by priority
-    std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) {
-        return a.second > b.second;
-    });
+    // Swap the highest scoring remaining move to the front and return it
+    Move pickBest() {
+        int best = index;
+        for (int i = index + 1; i < moves.size(); i++) {
+            if (scores[i] > scores[best]) {
+                best = i;
+            }
+        }
+        std::swap(moves[index], moves[best]);
+        std::swap(scores[index], scores[best]);
+        return moves[index++];
+    }
 
-    for (const auto& move : quietCandidates) {
-        candidates.push_back(move);
+    bool isSearched(Move move) const {
+        return move == pvMove || move == hashMove;
     }
 
-    return candidates;
-}
+    bool isKiller(Move move) const {
+        for (int i = 0; i < numKillers; i++) {
+            if (killerMoves[i] == move) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    SearchThread& thread;
+    Board& board;
+    const CheckInfo& checkInfo;
+    int ply;
+    Stage stage = PV_MOVE;
+    Move pvMove;
+    Move hashMove;
+    Move killerMoves[2];
+    int numKillers = 0;
+    int killerIndex = 0;
+    Move counterMove = Move(Move::NO_MOVE);
+    bool inCheck = false; // The moves are the evasions given by the caller
+    Movelist moves; // Moves of the current stage
+    int scores[constants::MAX_MOVES]; // Ordering scores of the moves of the current stage
+    int index = 0;
+};
 
 /*-------------------------------------------------------------------------------------------- 
     Quiescence search for captures only.
 --------------------------------------------------------------------------------------------*/
-int quiescence(Board& board, int alpha, int beta) {
+int quiescence(SearchThread& thread, EvalBoard& board, int alpha, int beta) {
     
-    #pragma omp critical
-    nodeCount++;
+    countNode(thread);
+
+    // Any stored entry is at least as deep as a quiescence search. Quiescence results are not 
+    // stored, the depth 0 entries written by negamax are enough and storing every capture 
+    // sequence only evicts more useful entries.
+    TableEntry entry;
+    if (tableLookUp(board.hash(), entry) && tableCutoff(entry, alpha, beta)) {
+        return entry.eval;
+    }
 
     Movelist moves;
     movegen::legalmoves<movegen::MoveGenType::CAPTURE>(moves, board);
@@ -340,8 +1072,9 @@ int quiescence(Board& board, int alpha, int beta) {
     int color = board.sideToMove() == Color::WHITE ? 1 : -1;
     int standPat = 0;
 
-    // Non-nnue evaluation
-    standPat = color * evaluate(board);
+    // Non-nnue evaluation. The window is passed from white's point of view so the evaluation 
+    // can stop after material and piece-square tables when the position is far outside it.
+    standPat = color == 1 ? evaluate(board, alpha, beta) : -evaluate(board, -beta, -alpha);
 
     int bestScore = standPat;
     if (standPat >= beta) {
@@ -366,7 +1099,13 @@ int quiescence(Board& board, int alpha, int beta) {
             continue;
         }
 
-        int priority = see(board, move);
+        // Captures that lose material are unlikely to raise alpha. The rest are ordered by the 
+        // value of the captured piece and then by the value of the capturing piece (MVV-LVA).
+        if (!seeGe(board, move, 0)) {
+            continue;
+        }
+
+        int priority = 8 * victimValue - attackerValue / 100;
         candidateMoves.push_back({move, priority});
         
     }
@@ -378,7 +1117,7 @@ int quiescence(Board& board, int alpha, int beta) {
     for (const auto& [move, priority] : candidateMoves) {
         board.makeMove(move);
         int score = 0;
-        score = -quiescence(board, -beta, -alpha);
+        score = -quiescence(thread, board, -beta, -alpha);
         board.unmakeMove(move);
 
         bestScore = std::max(bestScore, score);
@@ -395,7 +1134,8 @@ int quiescence(Board& board, int alpha, int beta) {
 /*-------------------------------------------------------------------------------------------- 
     Negamax with alpha-beta pruning.
 --------------------------------------------------------------------------------------------*/
-int negamax(Board& board, 
+int negamax(SearchThread& thread, 
+            EvalBoard& board, 
             int depth, 
             int alpha, 
             int beta, 
@@ -404,102 +1144,119 @@ int negamax(Board& board,
             int extension, 
             int ply) {
 
-    #pragma omp critical
-    clearTables();
-
-    auto currentTime = std::chrono::high_resolution_clock::now();
-    if (currentTime >= hardDeadline) {
+    if (searchStopped()) {
         return 0;
     }
 
-    #pragma omp critical
-    nodeCount++;
+    countNode(thread);
 
     bool whiteTurn = board.sideToMove() == Color::WHITE;
-    bool endGameFlag = gamePhase(board) <= 12;
+    bool endGameFlag = probeMaterialTable(board).gamePhase <= 12;
     int color = whiteTurn ? 1 : -1;
     bool isPV = (alpha < beta - 1); // Principal variation node flag
     
-    // Check if the game is over
-    auto gameOverResult = board.isGameOver();
-    if (gameOverResult.first != GameResultReason::NONE) {
-        if (gameOverResult.first == GameResultReason::CHECKMATE) {
-            int ply = globalMaxDepth - depth;
-            return -(INF/2 - ply); 
-        }
+    // Draws that don't need move generation. Checkmate and stalemate are found from the moves 
+    // of the node: evasions are generated below when in check, otherwise the move loop is empty.
+    int mateScore = -(INF/2 - (thread.maxDepth - depth));
+    if (board.isHalfMoveDraw()) {
+        return board.getHalfMoveDrawType().first == GameResultReason::CHECKMATE ? mateScore : 0;
+    }
+    if (board.isInsufficientMaterial() || board.isRepetition()) {
         return 0;
     }
 
-    // Probe the transposition table
+    // Probe the transposition table. PV nodes only take fail-high cutoffs so the PV stays intact.
     U64 hash = board.hash();
-    bool found = false;
-    int storedEval;
-    
-    #pragma omp critical
-    {
-        if (tableLookUp(hash, depth, storedEval) && storedEval >= beta) {
-            #pragma 
-            {
-                tableHit++;
-            }
+    TableEntry entry;
+    int alphaOrig = alpha;
+    bool found = tableLookUp(hash, entry);
+    Move hashMove = found ? entry.move : Move(Move::NO_MOVE);
+
+    if (found && entry.depth >= depth) {
+        bool cutoff = isPV ? (entry.bound != BOUND_UPPER && entry.eval >= beta) 
+                           : tableCutoff(entry, alpha, beta);
+        if (cutoff) {
+            thread.tableHits.store(thread.tableHits.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+            return entry.eval;
+        }
+    } 
 
-            found = true;
+    // In check, the evasions are few and cheap to generate. No evasion means checkmate, even at 
+    // the horizon where quiescence search would only look at captures. The list is handed to the 
+    // move picker so the moves are generated only once.
+    bool inCheck = board.inCheck();
+    bool isOneReply = false;
+    Movelist evasions;
+    if (inCheck) {
+        movegen::legalmoves(evasions, board);
+        if (evasions.empty()) {
+            return mateScore;
         }
+        isOneReply = evasions.size() == 1;
     }
 
-    if (found) {
-        return storedEval;
-    } 
+    if (depth <= 0 || ply >= MAX_PLY) {
+        int quiescenceEval = quiescence(thread, board, alpha, beta);
+        Bound bound = quiescenceEval >= beta ? BOUND_LOWER 
+                    : quiescenceEval <= alpha ? BOUND_UPPER : BOUND_EXACT;
 
-    if (depth <= 0) {
-        int quiescenceEval = quiescence(board, alpha, beta);
-        
-        #pragma omp critical
-        {
-            transpositionTable[hash] = {quiescenceEval, 0};
-        }
-            
+        tableStore(hash, quiescenceEval, 0, bound, Move::NO_MOVE);
         return quiescenceEval;
     }
 
+    /*--------------------------------------------------------------------------------------------
+        Static evaluation of the node, from the transposition table if it was stored there, 
+        otherwise from evaluate (which has its own cache). It is kept on the search stack so 
+        that a node can tell whether its position is improving on the one two plies up.
+    --------------------------------------------------------------------------------------------*/
+    int staticEval = EVAL_NONE;
 
+    if (!inCheck) {
+        staticEval = (found && entry.staticEval != EVAL_NONE) ? entry.staticEval : color * evaluate(board);
+    }
+    thread.stack[ply].staticEval = staticEval;
+
+    bool improving = !inCheck && ply >= 2 && thread.stack[ply - 2].staticEval != EVAL_NONE 
+                    && staticEval > thread.stack[ply - 2].staticEval;
 
     // Only pruning if the position is not in check, mop up flag is not set, and it's not the endgame phase
     // Disable pruning for when alpha is very high to avoid missing checkmates
-    
-    bool pruningCondition = !board.inCheck() && !mopUp && !endGameFlag && alpha < INF/4 && alpha > -INF/4;
-    int standPat = color * materialImbalance(board);//color * evaluate(board);
+    bool pruningCondition = !inCheck && !thread.mopUp && !endGameFlag && alpha < INF/4 && alpha > -INF/4;
 
-    //  Futility pruning
+    // Reverse futility pruning
     if (depth < 3 && pruningCondition) {
-        int margin = depth * 130;
-        if (standPat - margin > beta) {
+        int margin = depth * (improving ? 100 : 130);
+        if (staticEval - margin > beta) {
             // If the static evaluation - margin > beta, 
             // then it is considered to be too good and most likely a cutoff
-            return standPat - margin;
+            return staticEval - margin;
         } 
     }
 
-    // // Razoring: Skip deep search if the position is too weak. Only applied to non-PV nodes.
+    // Razoring: Skip deep search if the position is too weak. Only applied to non-PV nodes.
     if (depth <= 3 && pruningCondition && !isPV) {
         int razorMargin = 400 + (depth - 1) * 60; // Threshold increases slightly with depth
 
-        if (standPat + razorMargin < alpha) {
+        if (staticEval + razorMargin < alpha) {
             // If the position is too weak and unlikely to raise alpha, skip deep search
-            return quiescence(board, alpha, beta);
+            return quiescence(thread, board, alpha, beta);
         } 
     }
 
-    // Null move pruning. Avoid null move pruning in the endgame phase.
+    // Null move pruning. Avoid null move pruning in the endgame phase, and when the static 
+    // evaluation is already below beta since passing is then unlikely to fail high.
     const int nullDepth = 4; // Only apply null move pruning at depths >= 4
 
-    if (depth >= nullDepth && !endGameFlag && !leftMost && !board.inCheck() && !mopUp) {
+    if (depth >= nullDepth && !endGameFlag && !leftMost && !inCheck && !thread.mopUp 
+        && staticEval != EVAL_NONE && staticEval >= beta) {
         std::vector<Move> nullPV;
         int nullEval;
         int reduction = 3 + depth / 4;
 
+        thread.stack[ply].move = Move(Move::NULL_MOVE);
         board.makeNullMove();
-        nullEval = -negamax(board, depth - reduction, -beta, -(beta - 1), nullPV, false, extension, ply + 1);
+        nullEval = -negamax(thread, board, depth - reduction, -beta, -(beta - 1), nullPV, false, extension, ply + 1);
         board.unmakeNullMove();
 
         if (nullEval >= beta) { 
@@ -509,28 +1266,56 @@ int negamax(Board& board,
         } 
     }
 
-    std::vector<std::pair<Move, int>> moves = orderedMoves(board, depth, previousPV, leftMost);
+    // The previous iteration's PV move is tried first along the leftmost path
+    Move pvMove = Move::NO_MOVE;
+    int pvPly = thread.maxDepth - depth;
+    if (leftMost && pvPly >= 0 && thread.previousPV.size() > pvPly) {
+        pvMove = thread.previousPV[pvPly];
+    }
+
+    CheckInfo checkInfo = computeCheckInfo(board);
+    MovePicker picker(thread, board, checkInfo, ply, pvMove, hashMove, thread.killers[ply], 
+                      inCheck ? &evasions : nullptr);
     int bestEval = -INF;
+    Move bestMove = Move::NO_MOVE;
+
+    // Futility pruning: at shallow depths, quiet moves that can't bring the static evaluation 
+    // up to alpha are skipped. More margin when improving since the position is getting better.
+    bool futilityCondition = depth <= 2 && pruningCondition && !isPV;
+    int futilityValue = staticEval + 100 + 120 * depth + (improving ? 50 : 0);
 
-    for (int i = 0; i < moves.size(); i++) {
+    // Quiet moves searched so far, their history is lowered if a later move cuts off
+    Move quietsSearched[64];
+    int numQuiets = 0;
+
+    int numMoves = 0;
+    Move move;
+    for (int i = 0; (move = picker.next()) != Move::NO_MOVE; i++) {
+        numMoves++;
 
-        Move move = moves[i].first;
         std::vector<Move> childPV;
 
         int eval = 0;
-        int nextDepth = lateMoveReduction(board, move, i, depth, ply, isPV); 
+        bool isCheck = givesCheck(board, checkInfo, move);
+        bool isQuiet = !board.isCapture(move) && !isPromotion(move);
+
+        if (futilityCondition && i > 0 && isQuiet && !isCheck && futilityValue <= alpha) {
+            bestEval = std::max(bestEval, futilityValue);
+            continue;
+        }
+
+        int nextDepth = lateMoveReduction(thread, board, move, isCheck, i, depth, ply, isPV, improving); 
         
         if (i > 0) {
             leftMost = false;
         }
 
+        thread.stack[ply].move = move;
+        thread.stack[ply].movedPiece = board.at(move.from());
         board.makeMove(move);
-        
-        // Check for extensions
-        bool isCheck = board.inCheck();
+
         bool isMateThreat = mateThreatMove(board, move);
         bool isPromotionThreat = promotionThreatMove(board, move);
-        bool isOneReply = (moves.size() == 1);
         bool extensionFlag = (isCheck || isMateThreat || isPromotionThreat) && extension > 0; // if the move is a check, extend the search
         
         if (extensionFlag) {
@@ -569,13 +1354,13 @@ int negamax(Board& board,
         --------------------------------------------------------------------------------------------*/
 
         bool nullWindow = false;
-        if (i == 0 || mopUp) {
+        if (i == 0 || thread.mopUp) {
             // full window & full depth search for the first node
-            eval = -negamax(board, nextDepth, -beta, -alpha, childPV, leftMost, extension, ply + 1);
+            eval = -negamax(thread, board, nextDepth, -beta, -alpha, childPV, leftMost, extension, ply + 1);
         } else {
             // null window and potential reduced depth for the rest
             nullWindow = true;
-            eval = -negamax(board, nextDepth, -(alpha + 1), -alpha, childPV, leftMost, extension, ply + 1);
+            eval = -negamax(thread, board, nextDepth, -(alpha + 1), -alpha, childPV, leftMost, extension, ply + 1);
         }
         
         board.unmakeMove(move);
@@ -585,7 +1370,7 @@ int negamax(Board& board,
         if (alphaRaised && reducedDepth && nullWindow) {
             // If alpha is raised and we reduced the depth, research with full depth but still with a null window
             board.makeMove(move);
-            eval = -negamax(board, depth - 1, -(alpha + 1), -alpha, childPV, leftMost, extension, ply + 1);
+            eval = -negamax(thread, board, depth - 1, -(alpha + 1), -alpha, childPV, leftMost, extension, ply + 1);
             board.unmakeMove(move);
         } 
 
@@ -595,11 +1380,12 @@ int negamax(Board& board,
         if (alphaRaised && nullWindow) {
             // If alpha is raised, research with full window & full depth (we don't do this for i = 0)
             board.makeMove(move);
-            eval = -negamax(board, depth - 1, -beta, -alpha, childPV, leftMost, extension, ply + 1);
+            eval = -negamax(thread, board, depth - 1, -beta, -alpha, childPV, leftMost, extension, ply + 1);
             board.unmakeMove(move);
         }
 
         if (eval > alpha) {
+            bestMove = move;
             PV.clear();
             PV.push_back(move);
             for (auto& move : childPV) {
@@ -612,30 +1398,47 @@ int negamax(Board& board,
 
         if (beta <= alpha) {
             if (!board.isCapture(move) && !isCheck) {
-                updateKillerMoves(move, depth);
+                updateKillerMoves(thread, move, ply);
+            }
+
+            if (isQuiet) {
+                updateQuietHistories(thread, board, move, ply, depth, quietsSearched, numQuiets);
             }
             break;
         }
-    }
 
-    #pragma omp critical
-    {
-        // Update hash tables
-        if (PV.size() > 0) {
-            transpositionTable[board.hash()] = {bestEval, depth}; 
-            hashMoveTable[board.hash()] = PV[0];
+        if (isQuiet && numQuiets < 64) {
+            quietsSearched[numQuiets++] = move;
         }
     }
 
-    #pragma omp critical
-    clearTables();
+    // Not in check and no legal moves
+    if (numMoves == 0) {
+        return 0;
+    }
+
+    // Results of an aborted search are not reliable
+    if (searchStopped()) {
+        return bestEval;
+    }
+
+    // Update the transposition table. Fail-lows are stored as upper bounds without a move.
+    Bound bound = bestEval >= beta ? BOUND_LOWER 
+                : bestEval > alphaOrig ? BOUND_EXACT : BOUND_UPPER;
+    tableStore(hash, bestEval, depth, bound, bestMove, staticEval);
 
     return bestEval;
 }
 
 /*-------------------------------------------------------------------------------------------- 
-    Main search function to communicate with UCI interface.
-    Time control: 
+    Iterative deepening over the root moves, run by every search thread on its own board.
+    Thread 0 is the main thread: it reports each iteration and decides when to stop.
+    Helper threads only fill the shared transposition table. Odd helpers search one ply deeper
+    and every helper rotates its root moves after the best one, so the threads spread over 
+    different parts of the tree instead of repeating the main thread's work.
+
+    Time control (main thread): 
+
     Soft deadline: 2x time limit
     Hard deadline: 3x time limit
 
@@ -646,15 +1449,14 @@ int negamax(Board& board,
                   continue searching.
     - Case 3: If we are past the hard deadline, stop the search and return the best move.
 --------------------------------------------------------------------------------------------*/
-Move findBestMove(Board& board, 
-                int numThreads = 4, 
-                int maxDepth = 8, 
-                int timeLimit = 15000,
-                bool quiet = false) {
-
-    auto startTime = std::chrono::high_resolution_clock::now();
-    hardDeadline = startTime + 3 * std::chrono::milliseconds(timeLimit);
-    softDeadline = startTime + 2 * std::chrono::milliseconds(timeLimit);
+Move iterativeDeepening(SearchThread& thread,
+                EvalBoard& board, 
+                int maxDepth, 
+                int timeLimit,
+                std::chrono::time_point<std::chrono::high_resolution_clock> startTime) {
+
+    int threadId = thread.id;
+    bool mainThread = (threadId == 0);
     bool timeLimitExceeded = false;
 
     Move bestMove = Move(); 
@@ -663,27 +1465,16 @@ Move findBestMove(Board& board,
 
     std::vector<std::pair<Move, int>> moves;
     std::vector<Move> globalPV (maxDepth);
-
-    if (board.us(Color::WHITE).count() == 1 || board.us(Color::BLACK).count() == 1) {
-        mopUp = true;
-    }
-
-    omp_set_num_threads(numThreads);
-
-    // Clear transposition tables
-    #pragma omp critical
-    clearTables();
     
     const int baseDepth = 1;
     int apsiration = color * evaluate(board);
-    int depth = baseDepth;
+    int depth = baseDepth + (mainThread ? 0 : threadId % 2);
     std::vector<int> evals (2 * ENGINE_DEPTH + 1, 0);
     std::vector<Move> candidateMove (2 * ENGINE_DEPTH + 1, Move());
+    CheckInfo rootCheckInfo = computeCheckInfo(board);
 
     while (depth <= maxDepth) {
-        nodeCount = 0;
-        globalMaxDepth = depth;
-        tableHit = 0;
+        thread.maxDepth = depth;
         
         // Track the best move for the current depth
         Move currentBestMove = Move();
@@ -691,8 +1482,13 @@ Move findBestMove(Board& board,
         std::vector<std::pair<Move, int>> newMoves;
         std::vector<Move> PV; // Principal variation
 
-        if (depth == baseDepth) {
-            moves = orderedMoves(board, depth, previousPV, false);
+        if (moves.empty()) {
+            TableEntry rootEntry;
+            Move rootHashMove = tableLookUp(board.hash(), rootEntry) ? rootEntry.move : Move(Move::NO_MOVE);
+            MovePicker picker(thread, board, rootCheckInfo, 0, Move::NO_MOVE, rootHashMove, nullptr);
+            for (Move move = picker.next(); move != Move::NO_MOVE; move = picker.next()) {
+                moves.push_back({move, 0});
+            }
         }
         auto iterationStartTime = std::chrono::high_resolution_clock::now();
 
@@ -703,11 +1499,14 @@ Move findBestMove(Board& board,
 
             Move move = moves[i].first;
             std::vector<Move> childPV; 
-            int extension = mopUp ? 0 : 3;
+            int extension = thread.mopUp ? 0 : 3;
         
-            Board localBoard = board;
+            EvalBoard localBoard = board;
             bool newBestFlag = false;  
-            int nextDepth = lateMoveReduction(localBoard, move, i, depth, 0, true);
+            bool isCheck = givesCheck(localBoard, rootCheckInfo, move);
+            // The root has no earlier static evaluation to improve on, like any node before ply 2
+            bool improving = false;
+            int nextDepth = lateMoveReduction(thread, localBoard, move, isCheck, i, depth, 0, true, improving);
             int eval = -INF;
             int aspiration;
 
@@ -726,7 +1525,6 @@ Move findBestMove(Board& board,
                 localBoard.makeMove(move);
 
                 // Check for extensions
-                bool isCheck = board.inCheck();
                 bool isMateThreat = mateThreatMove(board, move);
                 bool isPromotionThreat = promotionThreatMove(board, move);
                 bool isOneReply = (moves.size() == 1);
@@ -759,17 +1557,17 @@ Move findBestMove(Board& board,
                 int alpha = aspiration - windowLeft;
                 int beta = aspiration + windowRight;
 
-                if (mopUp) {
+                if (thread.mopUp) {
                     alpha = -INF;
                     beta = INF;
                 }
 
-                eval = -negamax(localBoard, nextDepth, -beta, -alpha, childPV, leftMost, extension, 0);
+                eval = -negamax(thread, localBoard, nextDepth, -beta, -alpha, childPV, leftMost, extension, 0);
                 localBoard.unmakeMove(move);
 
-                // Check if the time limit has been exceeded, if so the search 
-                // has not finished. Return the best move so far.
-                if (std::chrono::high_resolution_clock::now() >= hardDeadline) {
+                // Check if the search has been stopped, if so it has not finished. 
+                // Return the best move so far.
+                if (searchStopped()) {
                     return bestMove;
                 }
 
@@ -782,39 +1580,32 @@ Move findBestMove(Board& board,
                 }
             }
 
-            #pragma omp critical
-            {
-                if (eval > currentBestEval) {
-                    newBestFlag = true;
-                }
+            if (eval > currentBestEval) {
+                newBestFlag = true;
             }
 
             if (newBestFlag && nextDepth < depth - 1) {
                 localBoard.makeMove(move);
-                eval = -negamax(localBoard, depth - 1, -INF, INF, childPV, leftMost, extension, 0);
+                eval = -negamax(thread, localBoard, depth - 1, -INF, INF, childPV, leftMost, extension, 0);
                 localBoard.unmakeMove(move);
 
-                // Check if the time limit has been exceeded, if so the search 
-                // has not finished. Return the best move so far.
-                if (std::chrono::high_resolution_clock::now() >= hardDeadline) {
+                // Check if the search has been stopped, if so it has not finished. 
+                // Return the best move so far.
+                if (searchStopped()) {
                     return bestMove;
                 }
             }
 
-            #pragma omp critical
             newMoves.push_back({move, eval});
 
-            #pragma omp critical
-            {
-                if (eval > currentBestEval) {
-                    currentBestEval = eval;
-                    currentBestMove = move;
+            if (eval > currentBestEval) {
+                currentBestEval = eval;
+                currentBestMove = move;
 
-                    PV.clear();
+                PV.clear();
+                PV.push_back(move);
+                for (auto& move : childPV) {
                     PV.push_back(move);
-                    for (auto& move : childPV) {
-                        PV.push_back(move);
-                    }
                 }
             }
         }
@@ -828,18 +1619,29 @@ Move findBestMove(Board& board,
             return a.second > b.second;
         });
 
-        #pragma omp critical
-        {
-            transpositionTable[board.hash()] = {bestEval, depth};
-        }
+        tableStore(board.hash(), bestEval, depth, BOUND_EXACT, bestMove);
 
 
         moves = newMoves;
-        previousPV = PV;
+        thread.previousPV = PV;
+
+        // Every thread centers the next iteration's aspiration window on this result
+        evals[depth] = bestEval;
+        candidateMove[depth] = bestMove; 
+
+        if (!mainThread) {
+            // Diversify the helper's next iteration by rotating the moves after the best one
+            if (moves.size() > 2) {
+                int shift = 1 + (threadId - 1) % (moves.size() - 2);
+                std::rotate(moves.begin() + 1, moves.begin() + 1 + shift, moves.end());
+            }
+            depth++;
+            continue;
+        }
 
         std::string depthStr = "depth " +  std::to_string(PV.size());
         std::string scoreStr = "score cp " + std::to_string(color * bestEval);
-        std::string nodeStr = "nodes " + std::to_string(nodeCount);
+        std::string nodeStr = "nodes " + std::to_string(totalNodes());
 
         auto iterationEndTime = std::chrono::high_resolution_clock::now();
         std::string timeStr = "time " + std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(iterationEndTime - iterationStartTime).count());
@@ -857,16 +1659,12 @@ Move findBestMove(Board& board,
             return moves[0].first;
         }
 
-
         auto currentTime = std::chrono::high_resolution_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(currentTime - startTime).count();
 
         timeLimitExceeded = duration > timeLimit;
         bool spendTooMuchTime = currentTime >= softDeadline;
 
-        evals[depth] = bestEval;
-        candidateMove[depth] = bestMove; 
-
         // Check for stable evaluation
         bool stableEval = true;
         if (depth > 3 && std::abs(evals[depth] - evals[depth - 2]) > 40 &&  candidateMove[depth] != candidateMove[depth - 2]) {
@@ -885,9 +1683,96 @@ Move findBestMove(Board& board,
             depth++;
         }
     }
-    
-    #pragma omp critical
-    clearTables();
 
     return bestMove; 
-}
\ No newline at end of file
+}
+
+/*-------------------------------------------------------------------------------------------- 
+    Debug check that the move picker returns exactly the legal moves of a position, each once. 
+    The first legal moves are passed in as hash and killer moves so those stages are covered.
+--------------------------------------------------------------------------------------------*/
+bool movePickerMatchesMovegen(Board& board) {
+    Movelist legalMoves;
+    movegen::legalmoves(legalMoves, board);
+
+    Move hashMove = legalMoves.size() > 0 ? legalMoves[0] : Move(Move::NO_MOVE);
+    Move killers[2] = {Move(Move::NO_MOVE), Move(Move::NO_MOVE)};
+    for (int i = 1; i < 3 && i < legalMoves.size(); i++) {
+        killers[i - 1] = legalMoves[i];
+    }
+
+    auto thread = std::make_unique<SearchThread>();
+    CheckInfo checkInfo = computeCheckInfo(board);
+    MovePicker picker(*thread, board, checkInfo, 0, Move::NO_MOVE, hashMove, killers, 
+                      board.inCheck() ? &legalMoves : nullptr);
+
+    std::vector<std::uint16_t> expected;
+    std::vector<std::uint16_t> picked;
+    for (const auto& move : legalMoves) {
+        expected.push_back(move.move());
+    }
+    for (Move move = picker.next(); move != Move::NO_MOVE; move = picker.next()) {
+        picked.push_back(move.move());
+    }
+
+    std::sort(expected.begin(), expected.end());
+    std::sort(picked.begin(), picked.end());
+    return expected == picked;
+}
+
+/*-------------------------------------------------------------------------------------------- 
+    Main search function to communicate with UCI interface. Lazy SMP: numThreads threads run 
+    iterativeDeepening on their own copy of the board and share only the transposition table. 
+    The main thread's result is returned and its completion stops the helpers.
+--------------------------------------------------------------------------------------------*/
+Move findBestMove(Board& board, 
+                int numThreads = 4, 
+                int maxDepth = 8, 
+                int timeLimit = 15000,
+                bool quiet = false) {
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+    hardDeadline = startTime + 3 * std::chrono::milliseconds(timeLimit);
+    softDeadline = startTime + 2 * std::chrono::milliseconds(timeLimit);
+
+    bool mopUp = board.us(Color::WHITE).count() == 1 || board.us(Color::BLACK).count() == 1;
+
+    if (transpositionTable == nullptr) {
+        resizeTables(DEFAULT_HASH_MB);
+    }
+
+    // New search generation, entries from earlier searches become preferred victims
+    tableGeneration = (tableGeneration + 1) & 0x1F;
+
+    numThreads = std::max(numThreads, 1);
+    while (threadPool.size() < numThreads) {
+        threadPool.push_back(std::make_unique<SearchThread>());
+        threadPool.back()->id = threadPool.size() - 1;
+    }
+    threadPool.resize(numThreads);
+
+    for (auto& thread : threadPool) {
+        thread->nodes = 0;
+        thread->tableHits = 0;
+        thread->mopUp = mopUp;
+        ageHistory(*thread);
+    }
+
+    stopSearch = false;
+    Move bestMove = Move();
+
+    #pragma omp parallel num_threads(numThreads)
+    {
+        int threadId = omp_get_thread_num();
+        EvalBoard localBoard(board);
+
+        Move threadBestMove = iterativeDeepening(*threadPool[threadId], localBoard, maxDepth, timeLimit, startTime);
+
+        if (threadId == 0) {
+            bestMove = threadBestMove;
+            stopSearch = true;
+        }
+    }
+
+    return bestMove;
+}
@@ -6,9 +6,27 @@ using namespace chess;
 
 // Constants
 const int INF = 100000;
+const int DEFAULT_HASH_MB = 64; // Default transposition table size in megabytes
+const int DEFAULT_THREADS = 6; // Default number of search threads
 
 // Function Declarations
 
+/**
+ * Reallocate the transposition table to the given size in megabytes and clear it. If the
+ * memory is not available, the previous table is kept and an info string reports it.
+ */
+void resizeTables(int megabytes);
+
+/**
+ * Clear all search tables, e.g. when a new game starts.
+ */
+void clearTables();
+
+/**
+ * Debug check that the staged move picker returns every legal move of the position exactly once.
+ */
+bool movePickerMatchesMovegen(Board& board);
+
 Move findBestMove(
     Board &board,
     int numThreads,